@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "autopilot.h"
+
+//World all rollouts of this decision start from
+static struct world autopilot_base;
+static unsigned int autopilot_frame_ms;
+static Uint64 autopilot_deadline;
+
+//Candidates are taken by the threads one by one
+static SDL_atomic_t autopilot_next;
+static SDL_atomic_t autopilot_steps;
+static SDL_atomic_t autopilot_skipped;
+static double autopilot_values[autopilot_candidates_quantity];
+
+static SDL_Thread* autopilot_workers[AUTOPILOT_MAX_THREADS];
+static int autopilot_threads = 0;
+static SDL_sem* autopilot_start = NULL;
+static SDL_sem* autopilot_finished = NULL;
+static SDL_atomic_t autopilot_quit;
+
+static struct autopilot_stats autopilot_stats;
+
+//Direction 0-8: row is up/none/down, column is left/none/right
+static struct world_input directionInput(int direction)
+{
+    struct world_input input = {direction / 3 == 0, direction / 3 == 2, direction % 3 == 0, direction % 3 == 2, true};
+    return input;
+}
+
+//Keys of the candidate in the given step
+static struct world_input candidateInput(int candidate, int step)
+{
+    if (candidate < 9) return directionInput(candidate);
+
+    int first = (candidate - 9) / 2;
+    if (step < AUTOPILOT_HORIZON / 2) return directionInput(first);
+
+    //Stop, or keep the vertical part and turn back horizontally
+    if ((candidate - 9) % 2 == 0) return directionInput(4);
+    return directionInput(first / 3 * 3 + 2 - first % 3);
+}
+
+//Plays the candidate on a copy of the world, higher is better
+static double rollout(int candidate)
+{
+    struct world clone = autopilot_base;
+
+    for (int step = 0; step < AUTOPILOT_HORIZON; step++)
+    {
+        if (!worldStep(&clone, candidateInput(candidate, step), NULL))
+        {
+            //Later crash is better, but any crash is worse than surviving
+            SDL_AtomicAdd(&autopilot_steps, step + 1);
+            return step - 1000000.0;
+        }
+        worldTick(&clone, clone.currentTime + autopilot_frame_ms);
+    }
+    SDL_AtomicAdd(&autopilot_steps, AUTOPILOT_HORIZON);
+
+    //Points and packages count, then staying low and near the middle leaves the most room to dodge
+    float center = clone.player.x + PLAYER_WIDTH / 2;
+    return (clone.currentScore - autopilot_base.currentScore) * 10.0 + (clone.packages_picked - autopilot_base.packages_picked) * 50.0
+        + clone.player.y * 0.01 - fabs(center - SCREEN_WIDTH / 2) * 0.01;
+}
+
+static void runCandidates()
+{
+    int i;
+    while ((i = SDL_AtomicAdd(&autopilot_next, 1)) < autopilot_candidates_quantity)
+    {
+        //Candidates that don't fit in the budget are not considered
+        if (SDL_GetPerformanceCounter() > autopilot_deadline)
+        {
+            autopilot_values[i] = -INFINITY;
+            SDL_AtomicAdd(&autopilot_skipped, 1);
+        }
+        else autopilot_values[i] = rollout(i);
+    }
+}
+
+static int autopilotWorker(void* data)
+{
+    (void)data;
+    while (true)
+    {
+        SDL_SemWait(autopilot_start);
+        if (SDL_AtomicGet(&autopilot_quit)) break;
+        runCandidates();
+        SDL_SemPost(autopilot_finished);
+    }
+    return 0;
+}
+
+bool autopilotInit(int threads)
+{
+    //Calling thread does rollouts too
+    if (threads < 1) threads = SDL_GetCPUCount();
+    if (threads > AUTOPILOT_MAX_THREADS) threads = AUTOPILOT_MAX_THREADS;
+
+    SDL_AtomicSet(&autopilot_quit, 0);
+    autopilot_start = SDL_CreateSemaphore(0);
+    autopilot_finished = SDL_CreateSemaphore(0);
+    if (autopilot_start == NULL || autopilot_finished == NULL)
+    {
+        printf("Autopilot could not be started! SDL Error: %s\n", SDL_GetError());
+        return false;
+    }
+    autopilot_threads = 0;
+    for (int i = 0; i < threads - 1; i++)
+    {
+        autopilot_workers[autopilot_threads] = SDL_CreateThread(autopilotWorker, "autopilot", NULL);
+        if (autopilot_workers[autopilot_threads] != NULL) autopilot_threads++;
+    }
+    memset(&autopilot_stats, 0, sizeof(autopilot_stats));
+    return true;
+}
+
+struct world_input autopilotChoose(const struct world* w, unsigned int frame_ms, double budget_ms)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    autopilot_base = *w;
+    autopilot_frame_ms = frame_ms;
+    autopilot_deadline = start + (Uint64)(budget_ms * SDL_GetPerformanceFrequency() / 1000);
+    SDL_AtomicSet(&autopilot_next, 0);
+    SDL_AtomicSet(&autopilot_steps, 0);
+    SDL_AtomicSet(&autopilot_skipped, 0);
+
+    for (int i = 0; i < autopilot_threads; i++) SDL_SemPost(autopilot_start);
+    runCandidates();
+    for (int i = 0; i < autopilot_threads; i++) SDL_SemWait(autopilot_finished);
+
+    int best = 4;
+    for (int i = 0; i < autopilot_candidates_quantity; i++)
+    {
+        if (autopilot_values[i] > autopilot_values[best]) best = i;
+    }
+
+    autopilot_stats.decisions++;
+    autopilot_stats.skipped += SDL_AtomicGet(&autopilot_skipped);
+    autopilot_stats.rollouts += autopilot_candidates_quantity - SDL_AtomicGet(&autopilot_skipped);
+    autopilot_stats.steps += SDL_AtomicGet(&autopilot_steps);
+    autopilot_stats.time += SDL_GetPerformanceCounter() - start;
+    return candidateInput(best, 0);
+}
+
+struct autopilot_stats autopilotStats()
+{
+    return autopilot_stats;
+}
+
+void autopilotQuit()
+{
+    SDL_AtomicSet(&autopilot_quit, 1);
+    for (int i = 0; i < autopilot_threads; i++) SDL_SemPost(autopilot_start);
+    for (int i = 0; i < autopilot_threads; i++) SDL_WaitThread(autopilot_workers[i], NULL);
+    autopilot_threads = 0;
+
+    if (autopilot_start != NULL) SDL_DestroySemaphore(autopilot_start);
+    if (autopilot_finished != NULL) SDL_DestroySemaphore(autopilot_finished);
+    autopilot_start = NULL;
+    autopilot_finished = NULL;
+}
@@ -0,0 +1,42 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "world.h"
+
+//Steps simulated ahead for every candidate
+#define AUTOPILOT_HORIZON 40
+
+//Time the autopilot may spend on one decision
+#define AUTOPILOT_BUDGET_MS 4
+
+//Most threads used for rollouts
+#define AUTOPILOT_MAX_THREADS 16
+
+//9 directions held the whole time, then 9 directions followed by stopping or turning back
+#define autopilot_candidates_quantity 27
+
+//Work done by the autopilot, for soak tests and the benchmark
+struct autopilot_stats
+{
+    int decisions;
+    int rollouts;
+    int skipped;
+    Uint64 steps;
+    Uint64 time;
+};
+
+//Starts the rollout threads, threads < 1 means one per core
+bool autopilotInit(int threads);
+
+//Picks keys for the next step of the world by playing every candidate forward on a copy of it
+struct world_input autopilotChoose(const struct world* w, unsigned int frame_ms, double budget_ms);
+
+//Returns statistics collected since autopilotInit
+struct autopilot_stats autopilotStats();
+
+//Stops the rollout threads
+void autopilotQuit();
+
+#endif
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "capture.h"
+#include "writer.h"
+
+//Frame read back from the renderer and the video frames lost before it
+struct capture_slot
+{
+    Uint32* pixels;
+    int skips;
+};
+
+//A buffer is free again as soon as the encoder has converted it
+static struct capture_slot capture_slots[capture_buffers_quantity];
+static struct writer capture_writer;
+static SDL_atomic_t capture_written;
+static int capture_file = -1;
+static int capture_width, capture_height, capture_stride;
+
+//Converted frame, the encoder writes it again for video frames that were dropped
+static Uint8* capture_yuv = NULL;
+static bool capture_converted;
+
+//Frame converted last is not written yet
+static bool capture_pending;
+static size_t capture_yuv_size;
+static size_t capture_header_size;
+
+//Game side: time of the first frame, video frames that were due so far and how many of them were lost
+static unsigned int capture_start;
+static Uint32 capture_frames;
+static int capture_skipped;
+static struct capture_stats capture_stats;
+
+//ARGB to 4:2:0 YCbCr (BT.601), chroma is the average of 2x2 pixels
+static void convertFrame(const Uint32* argb, Uint8* yuv)
+{
+    int w = capture_width, h = capture_height;
+    Uint8* y_plane = yuv;
+    Uint8* u_plane = yuv + w * h;
+    Uint8* v_plane = u_plane + (w / 2) * (h / 2);
+
+    for (int y = 0; y < h; y += 2)
+    {
+        for (int x = 0; x < w; x += 2)
+        {
+            int r_sum = 0, g_sum = 0, b_sum = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                int px = x + (i & 1), py = y + (i >> 1);
+                Uint32 pixel = argb[py * capture_stride + px];
+                int r = pixel >> 16 & 0xFF, g = pixel >> 8 & 0xFF, b = pixel & 0xFF;
+                y_plane[py * w + px] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+                r_sum += r;
+                g_sum += g;
+                b_sum += b;
+            }
+            int r = r_sum / 4, g = g_sum / 4, b = b_sum / 4;
+            u_plane[(y / 2) * (w / 2) + x / 2] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+            v_plane[(y / 2) * (w / 2) + x / 2] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+        }
+    }
+}
+
+static void writeFrame()
+{
+    if (!writeAll(capture_file, "FRAME\n", 6) || !writeAll(capture_file, capture_yuv, capture_yuv_size))
+    {
+        printf("Failed to write video: %s\n", strerror(errno));
+        return;
+    }
+    SDL_AtomicAdd(&capture_written, 1);
+}
+
+//Converted frame is written only when the next one comes or the pass ends, so the buffer goes back
+//to the game right after the conversion
+static void encodeFrame(void* data, void* item)
+{
+    (void)data;
+    struct capture_slot* slot = item;
+
+    if (capture_pending) writeFrame();
+    capture_pending = false;
+
+    //Dropped video frames show the last frame that made it, so the video keeps the game's pace
+    for (int i = 0; i < slot->skips && capture_converted; i++) writeFrame();
+
+    convertFrame(slot->pixels, capture_yuv);
+    capture_converted = true;
+    capture_pending = true;
+}
+
+static void writeConverted(void* data)
+{
+    (void)data;
+    if (capture_pending) writeFrame();
+    capture_pending = false;
+}
+
+bool captureStart(const char* path, int width, int height)
+{
+    capture_file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (capture_file < 0)
+    {
+        printf("Unable to create video %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    //4:2:0 needs even sizes, an odd last row or column is left out
+    char header[64];
+    capture_stride = width;
+    capture_width = width & ~1;
+    capture_height = height & ~1;
+    capture_yuv_size = capture_width * capture_height * 3 / 2;
+    capture_header_size = sprintf(header, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", capture_width, capture_height, CAPTURE_FPS);
+
+    //Every page is touched now, so the first captured frames don't pay for page faults
+    bool allocated = true;
+    for (int i = 0; i < capture_buffers_quantity; i++)
+    {
+        capture_slots[i].pixels = malloc(width * height * sizeof(Uint32));
+        if (capture_slots[i].pixels == NULL) allocated = false;
+        else memset(capture_slots[i].pixels, 0, width * height * sizeof(Uint32));
+    }
+    capture_yuv = malloc(capture_yuv_size);
+    if (!allocated || capture_yuv == NULL || !writeAll(capture_file, header, capture_header_size))
+    {
+        printf("Video capture could not be started!\n");
+        captureStop();
+        return false;
+    }
+
+    memset(&capture_stats, 0, sizeof(capture_stats));
+    capture_frames = 0;
+    capture_skipped = 0;
+    capture_converted = false;
+    capture_pending = false;
+    SDL_AtomicSet(&capture_written, 0);
+    if (!writerStart(&capture_writer, "capture", capture_slots, sizeof(struct capture_slot), capture_buffers_quantity,
+                     encodeFrame, writeConverted, NULL))
+    {
+        printf("Video encoder could not be started! SDL Error: %s\n", SDL_GetError());
+        captureStop();
+        return false;
+    }
+    return true;
+}
+
+void captureFrame(SDL_Renderer* renderer, unsigned int now)
+{
+    if (capture_writer.thread == NULL) return;
+
+    //Video frame k is due k / CAPTURE_FPS seconds after the first one
+    if (capture_frames == 0) capture_start = now;
+    Uint64 elapsed = (Uint64)(now - capture_start) * CAPTURE_FPS;
+    if (elapsed < (Uint64)capture_frames * 1000) return;
+
+    //Game frames slower than the video lose the video frames in between
+    Uint32 due = elapsed / 1000 + 1;
+    capture_skipped += due - capture_frames - 1;
+    capture_stats.dropped += due - capture_frames - 1;
+    capture_frames = due;
+
+    struct capture_slot* slot = writerSlot(&capture_writer);
+    if (slot == NULL ||
+        SDL_RenderReadPixels(renderer, NULL, SDL_PIXELFORMAT_ARGB8888, slot->pixels, capture_stride * sizeof(Uint32)) < 0)
+    {
+        capture_skipped++;
+        capture_stats.dropped++;
+        return;
+    }
+
+    slot->skips = capture_skipped;
+    capture_skipped = 0;
+    writerPublish(&capture_writer);
+    capture_stats.captured++;
+}
+
+struct capture_stats captureStats()
+{
+    struct capture_stats stats = capture_stats;
+    stats.written = SDL_AtomicGet(&capture_written);
+    stats.bytes = capture_header_size + (Uint64)stats.written * (6 + capture_yuv_size);
+    return stats;
+}
+
+void captureStop()
+{
+    writerStop(&capture_writer);
+
+    for (int i = 0; i < capture_buffers_quantity; i++)
+    {
+        free(capture_slots[i].pixels);
+        capture_slots[i].pixels = NULL;
+    }
+    free(capture_yuv);
+    capture_yuv = NULL;
+
+    if (capture_file >= 0) close(capture_file);
+    capture_file = -1;
+}
@@ -0,0 +1,35 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+//Frames per second written to the video
+#define CAPTURE_FPS 30
+
+//Frames that can wait for the encoder, has to be a power of two
+#define capture_buffers_quantity 4
+
+//Frames handled by the capture since captureStart
+struct capture_stats
+{
+    int captured;
+    int dropped;
+    int written;
+    Uint64 bytes;
+};
+
+//Opens the Y4M file, allocates the frame buffers and starts the encoder thread
+bool captureStart(const char* path, int width, int height);
+
+//When a video frame is due at time now (ms), reads the frame being rendered into a free buffer and queues it.
+//Has to be called before SDL_RenderPresent. Never waits: without a free buffer the frame is dropped
+void captureFrame(SDL_Renderer* renderer, unsigned int now);
+
+//Returns statistics of the capture
+struct capture_stats captureStats();
+
+//Writes the queued frames, stops the encoder thread and closes the file
+void captureStop();
+
+#endif
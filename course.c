@@ -0,0 +1,213 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "course.h"
+
+static size_t chunkOffset(const struct course* c, uint32_t chunk)
+{
+    return c->header->data_offset + (size_t)chunk * c->header->chunk_asteroids * sizeof(struct course_asteroid);
+}
+
+static size_t chunkLength(const struct course* c, uint32_t chunk)
+{
+    uint64_t left = c->header->asteroids - (uint64_t)chunk * c->header->chunk_asteroids;
+    if (left > c->header->chunk_asteroids) left = c->header->chunk_asteroids;
+    return left * sizeof(struct course_asteroid);
+}
+
+static bool inWindow(struct course_window window, uint32_t chunk)
+{
+    return (chunk >= window.first && chunk <= window.last) || chunk < window.wrap;
+}
+
+//Tells the system what to do with one chunk
+static void adviseChunk(struct course* c, uint32_t chunk, bool needed)
+{
+    size_t offset = chunkOffset(c, chunk);
+    size_t length = chunkLength(c, chunk);
+    if (needed)
+    {
+        posix_fadvise(c->file, offset, length, POSIX_FADV_WILLNEED);
+        madvise((void*)(c->map + offset), length, MADV_WILLNEED);
+    }
+    else
+    {
+        //Pages are unmapped from the game first, then the file cache can drop them too
+        madvise((void*)(c->map + offset), length, MADV_DONTNEED);
+        posix_fadvise(c->file, offset, length, POSIX_FADV_DONTNEED);
+    }
+}
+
+//Advises chunks of the window that aren't in keep
+static void adviseWindow(struct course* c, struct course_window window, struct course_window keep, bool needed)
+{
+    for (uint32_t chunk = window.first; chunk <= window.last && chunk < c->header->chunks; chunk++)
+    {
+        if (!inWindow(keep, chunk)) adviseChunk(c, chunk, needed);
+    }
+    for (uint32_t chunk = 0; chunk < window.wrap && chunk < window.first; chunk++)
+    {
+        if (!inWindow(keep, chunk)) adviseChunk(c, chunk, needed);
+    }
+}
+
+//Chunk lookup and spawning both need asteroids sorted by time, and every chunk has to start at its indexed time.
+//Each chunk is let go right after it is checked, so opening a long course doesn't keep all of it in memory
+static bool sortedChunks(struct course* c)
+{
+    madvise((void*)c->map, c->size, MADV_SEQUENTIAL);
+
+    uint32_t previous = 0;
+    for (uint32_t chunk = 0; chunk < c->header->chunks; chunk++)
+    {
+        uint64_t first = (uint64_t)chunk * c->header->chunk_asteroids;
+        uint64_t count = chunkLength(c, chunk) / sizeof(struct course_asteroid);
+        bool sorted = c->asteroids[first].time == c->chunk_times[chunk] && c->chunk_times[chunk] >= previous;
+        for (uint64_t i = first; i < first + count && sorted; i++)
+        {
+            sorted = c->asteroids[i].time >= previous;
+            previous = c->asteroids[i].time;
+        }
+        adviseChunk(c, chunk, false);
+        if (!sorted) return false;
+    }
+    return true;
+}
+
+bool courseOpen(struct course* c, const char* path)
+{
+    memset(c, 0, sizeof(*c));
+    c->file = open(path, O_RDONLY);
+    if (c->file < 0)
+    {
+        printf("Unable to open course %s!\n", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(c->file, &info) < 0 || (size_t)info.st_size < sizeof(struct course_header))
+    {
+        printf("Course %s is too short!\n", path);
+        courseClose(c);
+        return false;
+    }
+    c->size = info.st_size;
+    c->map = mmap(NULL, c->size, PROT_READ, MAP_SHARED, c->file, 0);
+    if (c->map == MAP_FAILED)
+    {
+        printf("Unable to map course %s!\n", path);
+        c->map = NULL;
+        courseClose(c);
+        return false;
+    }
+
+    c->header = (const struct course_header*)c->map;
+    c->chunk_times = (const uint32_t*)(c->map + sizeof(struct course_header));
+
+    const struct course_header* h = c->header;
+    bool valid = h->magic == COURSE_MAGIC && h->version == COURSE_VERSION && h->record_size == sizeof(struct course_asteroid)
+        && h->chunk_asteroids > 0 && h->asteroids > 0 && h->duration_ms > 0
+        && h->chunks == (h->asteroids + h->chunk_asteroids - 1) / h->chunk_asteroids
+        && h->data_offset % COURSE_DATA_ALIGN == 0
+        && h->data_offset >= sizeof(struct course_header) + (uint64_t)h->chunks * sizeof(uint32_t)
+        && h->data_offset <= c->size && h->asteroids <= (c->size - h->data_offset) / sizeof(struct course_asteroid);
+    if (!valid)
+    {
+        printf("Course %s is damaged or written by a different version!\n", path);
+        courseClose(c);
+        return false;
+    }
+    c->asteroids = (const struct course_asteroid*)(c->map + h->data_offset);
+    if (courseAsteroid(c, h->asteroids - 1)->time > h->duration_ms)
+    {
+        printf("Course %s has asteroids after its end!\n", path);
+        courseClose(c);
+        return false;
+    }
+    if (!sortedChunks(c))
+    {
+        printf("Course %s has asteroids that are not sorted by time!\n", path);
+        courseClose(c);
+        return false;
+    }
+
+    //From now on only chunks near the current time are read, ahead of it by courseStream
+    madvise((void*)c->map, c->size, MADV_RANDOM);
+
+    //Nothing is loaded yet, pages left in the file cache by whoever wrote the course are let go as well
+    posix_fadvise(c->file, h->data_offset, 0, POSIX_FADV_DONTNEED);
+    c->window.first = 1;
+    c->window.last = 0;
+    c->window.wrap = 0;
+    return true;
+}
+
+const struct course_asteroid* courseAsteroid(const struct course* c, uint64_t i)
+{
+    return &c->asteroids[i];
+}
+
+uint32_t courseChunk(const struct course* c, uint32_t time)
+{
+    //Last chunk that starts at or before time
+    uint32_t low = 0;
+    uint32_t high = c->header->chunks;
+    while (high - low > 1)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        if (c->chunk_times[middle] <= time) low = middle;
+        else high = middle;
+    }
+    return low;
+}
+
+void courseStream(struct course* c, uint32_t time)
+{
+    uint32_t duration = c->header->duration_ms;
+    if (time > duration) time = duration;
+
+    struct course_window window;
+    window.first = courseChunk(c, time > COURSE_KEEP_BEHIND_MS ? time - COURSE_KEEP_BEHIND_MS : 0);
+    window.last = courseChunk(c, time + COURSE_READ_AHEAD_MS);
+
+    //Near the end of a lap the beginning of the next one is read ahead as well
+    window.wrap = 0;
+    if (time + COURSE_READ_AHEAD_MS > duration) window.wrap = courseChunk(c, time + COURSE_READ_AHEAD_MS - duration) + 1;
+
+    if (window.first == c->window.first && window.last == c->window.last && window.wrap == c->window.wrap) return;
+
+    adviseWindow(c, c->window, window, false);
+    adviseWindow(c, window, c->window, true);
+    c->window = window;
+}
+
+size_t courseResidentBytes(const struct course* c)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    size_t pages = (c->size + page - 1) / page;
+    unsigned char* resident = malloc(pages);
+    size_t bytes = 0;
+
+    if (resident != NULL && mincore((void*)c->map, c->size, resident) == 0)
+    {
+        for (size_t i = 0; i < pages; i++)
+        {
+            if (resident[i] & 1) bytes += page;
+        }
+    }
+    free(resident);
+    return bytes;
+}
+
+void courseClose(struct course* c)
+{
+    if (c->map != NULL) munmap((void*)c->map, c->size);
+    if (c->file >= 0) close(c->file);
+    c->map = NULL;
+    c->file = -1;
+    c->header = NULL;
+}
@@ -0,0 +1,97 @@
+#ifndef COURSE_H
+#define COURSE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//Marks the beginning of a course file ("SRC1")
+#define COURSE_MAGIC 0x31435253u
+#define COURSE_VERSION 1
+
+//Asteroids in one chunk, a chunk is the unit that is read ahead and let go
+#define COURSE_CHUNK_ASTEROIDS 4096
+
+//Asteroids start at this offset in the file, so chunks line up with pages
+#define COURSE_DATA_ALIGN 4096
+
+//Chunks are read this far ahead of the current time
+#define COURSE_READ_AHEAD_MS 10000
+
+//Chunks are kept this far behind the current time, enough for rewinding
+#define COURSE_KEEP_BEHIND_MS 6000
+
+//One asteroid of a course. The game reads them straight from the mapped file, so every field sits at its natural
+//alignment and the struct has no gaps
+struct course_asteroid
+{
+    //Ms since the start of the course when the asteroid appears
+    uint32_t time;
+    int16_t x;
+    int16_t y;
+    //Speed in thousandths of a pixel per step
+    uint16_t speed;
+    //Starting angle in degrees and rotation in hundredths of a degree per step
+    uint16_t angle;
+    uint8_t size;
+    uint8_t texture;
+    uint8_t rotation;
+    uint8_t reserved;
+};
+
+//Beginning of a course file. It is followed by the spawn time of the first asteroid of every chunk,
+//then by all asteroids sorted by time starting at data_offset
+struct course_header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t chunk_asteroids;
+    uint32_t chunks;
+    uint64_t asteroids;
+    uint64_t data_offset;
+    //Length of one lap, the course starts again after it
+    uint32_t duration_ms;
+    uint32_t reserved;
+};
+
+//Chunks that are kept loaded: first to last, and the first wrap chunks when the next lap is close
+struct course_window
+{
+    uint32_t first;
+    uint32_t last;
+    uint32_t wrap;
+};
+
+//Course file mapped into memory, only chunks near the current time are kept loaded
+struct course
+{
+    int file;
+    const unsigned char* map;
+    size_t size;
+    const struct course_header* header;
+    const uint32_t* chunk_times;
+    const struct course_asteroid* asteroids;
+
+    struct course_window window;
+};
+
+//Maps the course file and checks it, returns false when it can't be used
+bool courseOpen(struct course* c, const char* path);
+
+//Returns the asteroid with the given index
+const struct course_asteroid* courseAsteroid(const struct course* c, uint64_t i);
+
+//Returns the chunk the course is in at the given ms of a lap
+uint32_t courseChunk(const struct course* c, uint32_t time);
+
+//Reads chunks ahead of the given ms of a lap and lets go of the ones long behind it
+void courseStream(struct course* c, uint32_t time);
+
+//Bytes of the course that are loaded in memory now
+size_t courseResidentBytes(const struct course* c);
+
+//Unmaps the course file
+void courseClose(struct course* c);
+
+#endif
@@ -0,0 +1,463 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <SDL2/SDL.h>
+#include "leaderboard.h"
+#include "writer.h"
+
+//Records read from the file at once when it is opened
+#define leaderboard_read_quantity 4096
+
+//Quantity of runs waiting for the writer, has to be a power of two
+#define leaderboard_ring_quantity 16
+
+//FNV-1a over the record without its checksum
+static uint32_t recordChecksum(const struct leaderboard_record* record)
+{
+    const uint8_t* bytes = (const uint8_t*)record;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(struct leaderboard_record, checksum); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void leaderboardSeal(struct leaderboard_record* record)
+{
+    record->magic = LEADERBOARD_MAGIC;
+    record->checksum = recordChecksum(record);
+}
+
+//True when a comes before b in the rank order
+static bool better(const struct leaderboard_entry* a, const struct leaderboard_entry* b)
+{
+    return a->score > b->score || (a->score == b->score && a->record < b->record);
+}
+
+static int compareEntry(const void* a, const void* b)
+{
+    return better(a, b) ? -1 : better(b, a) ? 1 : 0;
+}
+
+//Entries of the sorted run that come before run in the rank order
+static uint64_t aheadIn(const struct leaderboard_entry* entries, uint64_t count, const struct leaderboard_entry* run)
+{
+    uint64_t low = 0, high = count;
+    while (low < high)
+    {
+        uint64_t middle = low + (high - low) / 2;
+        if (better(&entries[middle], run)) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+//Reads length bytes at offset, pread can give back less than asked for. False on an error or when the file ends first
+static bool readAt(int file, void* data, size_t length, off_t offset)
+{
+    char* bytes = data;
+    while (length > 0)
+    {
+        ssize_t got = pread(file, bytes, length, offset);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        bytes += got;
+        length -= got;
+        offset += got;
+    }
+    return true;
+}
+
+static void unmapIndex(struct leaderboard* lb)
+{
+    if (lb->map != NULL) munmap(lb->map, lb->map_size);
+    lb->map = NULL;
+    lb->map_size = 0;
+    lb->index = NULL;
+    lb->index_records = 0;
+}
+
+//Maps the index file, returns false when it is missing or doesn't match the record file
+static bool mapIndex(struct leaderboard* lb, uint64_t records)
+{
+    unmapIndex(lb);
+    int file = open(lb->index_path, O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat info;
+    if (fstat(file, &info) < 0 || (size_t)info.st_size < sizeof(struct leaderboard_header))
+    {
+        close(file);
+        return false;
+    }
+    void* map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if (map == MAP_FAILED) return false;
+
+    const struct leaderboard_header* header = map;
+    if (header->magic != LEADERBOARD_INDEX_MAGIC || header->version != LEADERBOARD_VERSION
+        || header->entry_size != sizeof(struct leaderboard_entry) || header->records > records
+        || (uint64_t)info.st_size != sizeof(*header) + header->records * sizeof(struct leaderboard_entry))
+    {
+        munmap(map, info.st_size);
+        return false;
+    }
+
+    //Queries jump around the whole index
+    madvise(map, info.st_size, MADV_RANDOM);
+    lb->map = map;
+    lb->map_size = info.st_size;
+    lb->index = (const struct leaderboard_entry*)(header + 1);
+    lb->index_records = header->records;
+    return true;
+}
+
+static bool growFresh(struct leaderboard* lb, uint64_t capacity)
+{
+    if (capacity <= lb->fresh_capacity) return true;
+    if (capacity < lb->fresh_capacity * 2) capacity = lb->fresh_capacity * 2;
+    struct leaderboard_entry* bigger = realloc(lb->fresh, capacity * sizeof(struct leaderboard_entry));
+    if (bigger == NULL) return false;
+    lb->fresh = bigger;
+    lb->fresh_capacity = capacity;
+    return true;
+}
+
+//Merges the pending run into the fresh run from the back, so nothing has to be copied twice
+static bool mergePending(struct leaderboard* lb)
+{
+    if (!growFresh(lb, lb->fresh_count + lb->pending_count)) return false;
+
+    int64_t i = lb->fresh_count - 1, j = lb->pending_count - 1, k = lb->fresh_count + lb->pending_count - 1;
+    while (j >= 0)
+    {
+        if (i >= 0 && better(&lb->pending[j], &lb->fresh[i])) lb->fresh[k--] = lb->fresh[i--];
+        else lb->fresh[k--] = lb->pending[j--];
+    }
+    lb->fresh_count += lb->pending_count;
+    lb->pending_count = 0;
+    return true;
+}
+
+//Puts a run into the pending run, after the runs with the same score because it is the newest
+static bool insertEntry(struct leaderboard* lb, const struct leaderboard_entry* entry)
+{
+    if (lb->pending_count == leaderboard_pending_quantity && !mergePending(lb)) return false;
+
+    uint64_t at = aheadIn(lb->pending, lb->pending_count, entry);
+    memmove(&lb->pending[at + 1], &lb->pending[at], (lb->pending_count - at) * sizeof(struct leaderboard_entry));
+    lb->pending[at] = *entry;
+    lb->pending_count++;
+    return true;
+}
+
+//Closes a leaderboard that couldn't be opened whole, the runs read so far aren't sorted so no index is written
+static void abandonOpen(struct leaderboard* lb)
+{
+    close(lb->file);
+    lb->file = -1;
+    leaderboardClose(lb);
+}
+
+bool leaderboardOpen(struct leaderboard* lb, const char* path, const char* index_path)
+{
+    memset(lb, 0, sizeof(*lb));
+    lb->file = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    lb->index_path = malloc(strlen(index_path) + 1);
+    if (lb->file < 0 || lb->index_path == NULL)
+    {
+        printf("Unable to open leaderboard %s: %s\n", path, strerror(errno));
+        leaderboardClose(lb);
+        return false;
+    }
+    strcpy(lb->index_path, index_path);
+
+    off_t size = lseek(lb->file, 0, SEEK_END);
+    uint64_t whole = size > 0 ? size / sizeof(struct leaderboard_record) : 0;
+    if (!mapIndex(lb, whole) && whole > 0) printf("Leaderboard index %s is rebuilt\n", index_path);
+
+    //Runs the index doesn't cover are read again; the first one that isn't whole was cut off by a crash and ends the file
+    static struct leaderboard_record batch[leaderboard_read_quantity];
+    uint64_t valid = lb->index_records;
+    bool broken = false;
+    while (valid < whole && !broken)
+    {
+        uint64_t count = SDL_min(whole - valid, (uint64_t)leaderboard_read_quantity);
+        //Runs that can't be read aren't broken, the file is left as it is
+        if (!readAt(lb->file, batch, count * sizeof(struct leaderboard_record), valid * sizeof(struct leaderboard_record)))
+        {
+            printf("Unable to read leaderboard %s\n", path);
+            abandonOpen(lb);
+            return false;
+        }
+        if (!growFresh(lb, lb->fresh_count + count))
+        {
+            printf("Not enough memory for the leaderboard!\n");
+            abandonOpen(lb);
+            return false;
+        }
+
+        for (uint64_t i = 0; i < count && !broken; i++)
+        {
+            if (batch[i].magic != LEADERBOARD_MAGIC || batch[i].checksum != recordChecksum(&batch[i])) broken = true;
+            else
+            {
+                struct leaderboard_entry entry = {batch[i].score, batch[i].duration_ms, valid++};
+                lb->fresh[lb->fresh_count++] = entry;
+            }
+        }
+    }
+    if ((uint64_t)size != valid * sizeof(struct leaderboard_record))
+    {
+        printf("Leaderboard %s ended with a broken run, it is cut off\n", path);
+        if (ftruncate(lb->file, valid * sizeof(struct leaderboard_record)) < 0) printf("Unable to cut off the broken run\n");
+    }
+    lb->records = valid;
+
+    //Read runs are sorted once, a rebuilt index is written right away
+    qsort(lb->fresh, lb->fresh_count, sizeof(struct leaderboard_entry), compareEntry);
+    if (lb->fresh_count >= SDL_max(lb->index_records / LEADERBOARD_FRESH_SHARE, (uint64_t)leaderboard_pending_quantity))
+    {
+        leaderboardFlush(lb);
+    }
+    return true;
+}
+
+bool leaderboardAppend(struct leaderboard* lb, const struct leaderboard_record* records, int count)
+{
+    //A run that couldn't be written whole is taken back, so the file never has a gap
+    if (!writeAll(lb->file, records, count * sizeof(struct leaderboard_record)))
+    {
+        printf("Failed to write leaderboard: %s\n", strerror(errno));
+        if (ftruncate(lb->file, lb->records * sizeof(struct leaderboard_record)) < 0) printf("Unable to take the run back\n");
+        return false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        struct leaderboard_entry entry = {records[i].score, records[i].duration_ms, lb->records++};
+        if (!insertEntry(lb, &entry))
+        {
+            printf("Not enough memory for the leaderboard!\n");
+            return false;
+        }
+    }
+
+    //Fresh run stays a small part of the index, so every run is copied into the file only a few times
+    if (lb->fresh_count >= SDL_max(lb->index_records / LEADERBOARD_FRESH_SHARE, (uint64_t)leaderboard_pending_quantity))
+    {
+        return leaderboardFlush(lb);
+    }
+    return true;
+}
+
+uint64_t leaderboardAhead(const struct leaderboard* lb, int32_t score, uint64_t record)
+{
+    struct leaderboard_entry run = {score, 0, record};
+    return aheadIn(lb->index, lb->index_records, &run) + aheadIn(lb->fresh, lb->fresh_count, &run)
+           + aheadIn(lb->pending, lb->pending_count, &run);
+}
+
+int leaderboardTop(const struct leaderboard* lb, int k, struct leaderboard_entry* top)
+{
+    //Each run is sorted, so the best k are at their fronts
+    const struct leaderboard_entry* runs[3] = {lb->index, lb->fresh, lb->pending};
+    uint64_t counts[3] = {lb->index_records, lb->fresh_count, lb->pending_count};
+    uint64_t at[3] = {0, 0, 0};
+    int copied = 0;
+
+    while (copied < k)
+    {
+        int best = -1;
+        for (int i = 0; i < 3; i++)
+        {
+            if (at[i] < counts[i] && (best < 0 || better(&runs[i][at[i]], &runs[best][at[best]]))) best = i;
+        }
+        if (best < 0) break;
+        top[copied++] = runs[best][at[best]++];
+    }
+    return copied;
+}
+
+bool leaderboardRecord(const struct leaderboard* lb, uint64_t record, struct leaderboard_record* out)
+{
+    if (record >= lb->records) return false;
+    return pread(lb->file, out, sizeof(*out), record * sizeof(*out)) == sizeof(*out);
+}
+
+bool leaderboardFlush(struct leaderboard* lb)
+{
+    if (lb->index_records == lb->records) return true;
+    if (lb->pending_count > 0 && !mergePending(lb)) return false;
+
+    //Index may only cover runs that are on the disk
+    if (fdatasync(lb->file) < 0)
+    {
+        printf("Failed to write leaderboard: %s\n", strerror(errno));
+        return false;
+    }
+
+    //New index is written next to the old one and replaces it at once, a crash leaves one of them whole
+    char* temporary = malloc(strlen(lb->index_path) + 5);
+    if (temporary == NULL) return false;
+    sprintf(temporary, "%s.tmp", lb->index_path);
+    FILE* file = fopen(temporary, "wb");
+    if (file == NULL)
+    {
+        printf("Unable to create leaderboard index %s: %s\n", temporary, strerror(errno));
+        free(temporary);
+        return false;
+    }
+
+    struct leaderboard_header header = {LEADERBOARD_INDEX_MAGIC, LEADERBOARD_VERSION, sizeof(struct leaderboard_entry), lb->records};
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    static struct leaderboard_entry merged[leaderboard_read_quantity];
+    uint64_t i = 0, j = 0;
+    while (success && (i < lb->index_records || j < lb->fresh_count))
+    {
+        int count = 0;
+        while (count < leaderboard_read_quantity && (i < lb->index_records || j < lb->fresh_count))
+        {
+            if (j == lb->fresh_count || (i < lb->index_records && better(&lb->index[i], &lb->fresh[j]))) merged[count++] = lb->index[i++];
+            else merged[count++] = lb->fresh[j++];
+        }
+        success = fwrite(merged, sizeof(struct leaderboard_entry), count, file) == (size_t)count;
+    }
+    success = fflush(file) == 0 && fsync(fileno(file)) == 0 && success;
+    success = fclose(file) == 0 && success;
+    success = success && rename(temporary, lb->index_path) == 0;
+    if (!success)
+    {
+        printf("Failed to write leaderboard index %s: %s\n", lb->index_path, strerror(errno));
+        remove(temporary);
+        free(temporary);
+        return false;
+    }
+    free(temporary);
+
+    if (!mapIndex(lb, lb->records))
+    {
+        printf("Leaderboard index %s could not be mapped!\n", lb->index_path);
+        return false;
+    }
+    lb->fresh_count = 0;
+    return true;
+}
+
+void leaderboardClose(struct leaderboard* lb)
+{
+    if (lb->file >= 0 && lb->index_path != NULL) leaderboardFlush(lb);
+    unmapIndex(lb);
+    if (lb->file >= 0) close(lb->file);
+    lb->file = -1;
+    free(lb->index_path);
+    lb->index_path = NULL;
+    free(lb->fresh);
+    lb->fresh = NULL;
+    lb->fresh_count = 0;
+    lb->fresh_capacity = 0;
+    lb->pending_count = 0;
+}
+
+//Leaderboard of the game, only the writer changes it and only while it holds the lock
+static struct leaderboard leaderboard_store;
+static SDL_mutex* leaderboard_lock = NULL;
+
+static struct leaderboard_record leaderboard_ring[leaderboard_ring_quantity];
+static struct writer leaderboard_writer;
+
+//Runs taken from the ring in one pass, they are added with one write
+static struct leaderboard_record leaderboard_batch[leaderboard_ring_quantity];
+static int leaderboard_batch_count = 0;
+
+//Runs the writer has added to the leaderboard and runs it couldn't add, together equal to the writer head
+//when nothing is waiting
+static SDL_atomic_t leaderboard_written;
+static SDL_atomic_t leaderboard_failed;
+
+//Set when the last batch couldn't be added or didn't get to the disk
+static SDL_atomic_t leaderboard_last_failed;
+
+static void takeRun(void* data, void* item)
+{
+    (void)data;
+    leaderboard_batch[leaderboard_batch_count++] = *(struct leaderboard_record*)item;
+}
+
+static void writeRuns(void* data)
+{
+    (void)data;
+    SDL_LockMutex(leaderboard_lock);
+    bool added = leaderboardAppend(&leaderboard_store, leaderboard_batch, leaderboard_batch_count);
+    SDL_UnlockMutex(leaderboard_lock);
+
+    //Place is only shown for runs that are on the disk, queries don't have to wait for the sync
+    if (added && fdatasync(leaderboard_store.file) < 0)
+    {
+        printf("Failed to write leaderboard: %s\n", strerror(errno));
+        added = false;
+    }
+    SDL_AtomicSet(&leaderboard_last_failed, !added);
+    SDL_AtomicAdd(added ? &leaderboard_written : &leaderboard_failed, leaderboard_batch_count);
+    leaderboard_batch_count = 0;
+}
+
+bool leaderboardInit(const char* path, const char* index_path)
+{
+    if (!leaderboardOpen(&leaderboard_store, path, index_path)) return false;
+
+    SDL_AtomicSet(&leaderboard_written, 0);
+    SDL_AtomicSet(&leaderboard_failed, 0);
+    SDL_AtomicSet(&leaderboard_last_failed, 0);
+    leaderboard_lock = SDL_CreateMutex();
+    if (leaderboard_lock == NULL || !writerStart(&leaderboard_writer, "leaderboard", leaderboard_ring,
+                                                 sizeof(struct leaderboard_record), leaderboard_ring_quantity,
+                                                 takeRun, writeRuns, NULL))
+    {
+        printf("Leaderboard writer could not be started! SDL Error: %s\n", SDL_GetError());
+        leaderboardQuit();
+        return false;
+    }
+    return true;
+}
+
+bool leaderboardSubmit(const struct leaderboard_record* record)
+{
+    return writerSubmit(&leaderboard_writer, record);
+}
+
+bool leaderboardPlace(int32_t score, uint64_t* place, uint64_t* total)
+{
+    if (leaderboard_writer.thread == NULL) return false;
+    Uint32 done = SDL_AtomicGet(&leaderboard_written) + SDL_AtomicGet(&leaderboard_failed);
+    if (done != (Uint32)SDL_AtomicGet(&leaderboard_writer.head)) return false;
+    if (SDL_AtomicGet(&leaderboard_last_failed))
+    {
+        *place = 0;
+        *total = 0;
+        return true;
+    }
+    if (SDL_TryLockMutex(leaderboard_lock) != 0) return false;
+    //Every submitted run is written, so the last one is the newest record
+    *place = leaderboardAhead(&leaderboard_store, score, leaderboard_store.records - 1) + 1;
+    *total = leaderboard_store.records;
+    SDL_UnlockMutex(leaderboard_lock);
+    return true;
+}
+
+void leaderboardQuit()
+{
+    writerStop(&leaderboard_writer);
+    if (leaderboard_lock != NULL) SDL_DestroyMutex(leaderboard_lock);
+    leaderboard_lock = NULL;
+    if (leaderboard_store.index_path != NULL) leaderboardClose(&leaderboard_store);
+}
@@ -0,0 +1,121 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//Marks every run in the record file ("SRL1") and the rank index ("SRI1")
+#define LEADERBOARD_MAGIC 0x314C5253u
+#define LEADERBOARD_INDEX_MAGIC 0x31495253u
+#define LEADERBOARD_VERSION 1
+
+//Default files, runs are only ever appended to the first one, the second can always be built again from it
+#define LEADERBOARD_PATH "leaderboard.bin"
+#define LEADERBOARD_INDEX_PATH "leaderboard.idx"
+
+//Where a run was played
+#define LEADERBOARD_GAME 0
+#define LEADERBOARD_BATCH 1
+
+//Runs added last are kept sorted in memory, up to this many; they are then moved to the fresh run
+#define leaderboard_pending_quantity 4096
+
+//Fresh run is merged into the index file when it has 1 / LEADERBOARD_FRESH_SHARE of the entries the file has
+#define LEADERBOARD_FRESH_SHARE 8
+
+//One finished run as it is in the record file, the fields before the 64-bit time take 16 bytes so
+//nothing is padded. checksum covers everything before it, so a record cut off by a crash is found when the file is opened
+struct leaderboard_record
+{
+    uint32_t magic;
+    int32_t score;
+    uint32_t duration_ms;
+    uint16_t difficulty;
+    uint16_t source;
+    int64_t time;
+    uint32_t seed;
+    uint32_t checksum;
+};
+
+//One run in the rank order: higher score first, an earlier run first when scores are equal
+struct leaderboard_entry
+{
+    int32_t score;
+    uint32_t duration_ms;
+    uint64_t record;
+};
+
+//Start of the index file, entries sorted in rank order follow it
+struct leaderboard_header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;
+    uint64_t records;
+};
+
+//Leaderboard of one record file. The index file covers the first index_records runs, the rest are in two
+//sorted runs in memory, so a new run never moves more than the small pending run
+struct leaderboard
+{
+    int file;
+    char* index_path;
+
+    //Mapped index file, NULL when it is empty
+    void* map;
+    size_t map_size;
+    const struct leaderboard_entry* index;
+    uint64_t index_records;
+
+    struct leaderboard_entry* fresh;
+    uint64_t fresh_count;
+    uint64_t fresh_capacity;
+
+    struct leaderboard_entry pending[leaderboard_pending_quantity];
+    int pending_count;
+
+    //Runs in the record file
+    uint64_t records;
+};
+
+//Opens or creates both files. A record cut off by a crash is removed, runs the index doesn't cover are read again,
+//and a missing or broken index is built again from all runs
+bool leaderboardOpen(struct leaderboard* lb, const char* path, const char* index_path);
+
+//Fills the magic and checksum of the record
+void leaderboardSeal(struct leaderboard_record* record);
+
+//Appends count sealed records with one write and ranks them
+bool leaderboardAppend(struct leaderboard* lb, const struct leaderboard_record* records, int count);
+
+//Runs that come before run number record with score: a higher score, or the same score and an earlier run.
+//The run itself doesn't have to be added yet, its place is one after them. O(log n)
+uint64_t leaderboardAhead(const struct leaderboard* lb, int32_t score, uint64_t record);
+
+//Copies the k best runs to top in rank order, in O(k); returns how many were copied
+int leaderboardTop(const struct leaderboard* lb, int k, struct leaderboard_entry* top);
+
+//Reads run number record from the record file
+bool leaderboardRecord(const struct leaderboard* lb, uint64_t record, struct leaderboard_record* out);
+
+//Writes all runs to the index file, so the next open has nothing to read again
+bool leaderboardFlush(struct leaderboard* lb);
+
+//Flushes the index and closes both files
+void leaderboardClose(struct leaderboard* lb);
+
+//Game side: opens the leaderboard and starts the thread that writes to it
+bool leaderboardInit(const char* path, const char* index_path);
+
+//Queues a run for the writer, never blocks; returns false if the queue was full and the run was dropped
+bool leaderboardSubmit(const struct leaderboard_record* record);
+
+//Place of the run submitted last, which had score, and runs so far. Never waits: returns false while submitted
+//runs aren't added yet or the writer holds the leaderboard. place is 0 when the run couldn't be written
+bool leaderboardPlace(int32_t score, uint64_t* place, uint64_t* total);
+
+//Writes everything still queued, stops the writer and closes the leaderboard
+void leaderboardQuit();
+
+#endif
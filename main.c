@@ -7,17 +7,56 @@
 #include <math.h>
 #include <SDL2/SDL_mixer.h>
 #include <SDL2/SDL_ttf.h>
+#include "telemetry.h"
+#include "world.h"
+#include "rewind.h"
+#include "autopilot.h"
+#include "course.h"
+#include "spectator.h"
+#include "capture.h"
+#include "starfield.h"
+#include "leaderboard.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+const float PARTICLE_GRAVITY = 0.02;
+const float PARTICLE_DRAG = 0.98;
+const int BENCHMARK_FRAMES = 1000;
+
+//Video written by the capture benchmark, removed when it is done
+const char* CAPTURE_BENCH_PATH = "bench.y4m";
+
+//Leaderboard written by the leaderboard benchmark, removed when it is done
+const char* LEADERBOARD_BENCH_PATH = "bench.board";
+const char* LEADERBOARD_BENCH_INDEX_PATH = "bench.board.idx";
+const int LEADERBOARD_BENCH_RUNS = 2000000;
+
+//Stars are the same every time the game runs
+const unsigned int STARFIELD_SEED = 2077;
+
+//Asteroids are drawn from 30 to 100 px, so their textures are kept only in these sizes
+#define mip_levels 3
+const int MIP_SIZES[mip_levels] = {128, 64, 32};
+
+//Asteroid texture scaled down in advance, biggest level first
+struct mipmap
+{
+    SDL_Texture* levels[mip_levels];
+};
 
-const int SCREEN_WIDTH = 800;
-const int SCREEN_HEIGHT = 800;
-const int PLAYER_WIDTH = SCREEN_WIDTH / 12;
-const int PLAYER_HEIGHT = SCREEN_HEIGHT / 12;
-const int PLAYER_SPEED = 2;
-const int BULLET_WIDTH = 10;
-const int BULLET_HEIGHT = 10;
-const int BULLET_SPEED = 4;
-const int BULLET_COOLDOWN = 2;
-const int PACKAGE_SPEED = 2;
+//Time spent in one measured part of a frame
+struct profile
+{
+    const char* name;
+    Uint64 total;
+    Uint64 worst;
+    int samples;
+    long long misses;
+};
 /*------------------------------------------FUNCTIONS------------------------------------------*/
 
 //Starts up SDL and creates window
@@ -33,37 +72,28 @@ bool mixer_init();
 bool loadMedia();
 
 //Frees media and shuts down SDL
-void close();
+void closeSDL();
 
 //Loads individual image
 SDL_Texture* loadTexture(char* path);
 
-//Returns rectangle with player movement and creates bullets
-SDL_FRect keyboardCheck(SDL_FRect player);
-
-//Creates an asteroid
-void createAsteoid();
-
-//Creates a bullet
-void createBullet(SDL_FRect player);
+//Loads image as 32 bit surface with white background turned transparent
+SDL_Surface* loadSurface(char* path);
 
-//Creates a package with bullets
-void createPackage();
+//Returns size x size copy of the surface, every pixel is the average of the pixels it covers
+SDL_Surface* scaleSurface(SDL_Surface* source, int size);
 
-//converts SDL_Rect to SDL_FRect
-SDL_Rect convert(SDL_FRect frect);
+//Loads image and creates all its texture levels
+bool loadMipmap(char* path, struct mipmap* mip);
 
-//Checks all asteroids for collision
-bool collisionCheckAsteroid(SDL_FRect player);
+//Returns the smallest level that is at least size px, so it never gets enlarged
+SDL_Texture* mipmapLevel(struct mipmap* mip, float size);
 
-//Checks all bullets for collision
-bool collisionCheckBullet(int i);
-
-//Checks all packages for collision
-bool collisionCheckPackage(SDL_FRect player);
+//Returns keys held by the player
+struct world_input keyboardCheck();
 
 //Renders everything
-void render(SDL_FRect player);
+void render();
 
 //rendering asteroids
 void asteroids_render();
@@ -74,14 +104,68 @@ void render_scoreboard();
 //Game over screen
 void gameOver();
 
-//Lowers asteroids, packages and makes bullets go up
-void asteroidBulletAndPackageMovement();
+//Prepares the particle pool for drawing
+void particlesInit();
+
+//Creates sparks (hit) or debris (destroyed asteroid) around a point
+void createParticles(float x, float y, int count, bool debris);
+
+//Moves particles and removes the faded ones
+void particlesUpdate();
+
+//Renders all particles in one draw call
+void particles_render();
+
+//Adds time passed since start to the profile
+void profileAdd(struct profile* p, Uint64 start);
+
+//Prints average and worst time of the profile
+void profilePrint(struct profile* p);
+
+//Opens a counter of cache misses of this thread, returns -1 where there is none
+int cacheCounterOpen();
+
+//Returns cache misses counted so far
+long long cacheCounterRead(int counter);
+
+//Steps a field of count asteroids with one pass per job and with asteroidsUpdate, and prints both
+void benchmarkAsteroids(int count, int counter);
 
-//Counts score (+1 per dodged asteroid)
-void getScore(SDL_FRect player);
+//Updates and draws particles with asteroids exploding all the time, so the pool stays almost full
+void benchmarkParticles();
+
+//Saves every step of a scripted game, then restores all of it; returns false without memory for the history
+bool benchmarkRewind();
+
+//Lets the autopilot play forward all candidates from the current world every frame
+void benchmarkAutopilot();
+
+//Draws a full field of asteroids from the original images and from the scaled levels
+void benchmarkAsteroidTextures();
+
+//Clears the screen to one color and draws every starfield layer scrolled to its place
+void benchmarkStarfield();
+
+//Steps asteroid fields from the game's own quantity up to fields far bigger than the cache
+void benchmarkAsteroidStep();
+
+//Draws and records a scripted game as if it ran at 140 frames per second
+void benchmarkCapture();
+
+//Publishes every step of a scripted game to the spectator feed
+void benchmarkSpectator();
+
+//Adds as many runs as big batches do, then runs the queries of the game over screen and of a top list
+void benchmarkLeaderboard();
+
+//Plays one second of the course every tick, so the whole course is spawned and streamed
+void benchmarkCourse(const char* coursePath);
+
+//Runs fixed scenes without menu and sound and prints how long each part takes, a course is streamed when given
+int benchmark(const char* coursePath);
 
 //needed
-bool gameLoop(SDL_Event e, SDL_FRect *player_pointer);
+bool gameLoop(SDL_Event e);
 
 //comment
 void menu_render(SDL_Event e);
@@ -95,74 +179,78 @@ void option_render(SDL_Event e);
 SDL_Window* gWindow = NULL;
 SDL_Renderer* gRenderer = NULL;
 SDL_Texture* gTexturePlayer = NULL;
-SDL_Texture* gTextureAsteroid1 = NULL;
-SDL_Texture* gTextureAsteroid2 = NULL;
-SDL_Texture* gTextureAsteroid3 = NULL;
-SDL_Texture* gTextureAsteroid4 = NULL;
-SDL_Texture* gTextureAsteroid5 = NULL;
-SDL_Texture* gTextureAsteroid6 = NULL;
-SDL_Texture* gTextureAsteroid7 = NULL;
-SDL_Texture* gTextureAsteroid8 = NULL;
-SDL_Texture* gTextureAsteroid9 = NULL;
-SDL_Texture* textureList[9];
+struct mipmap asteroidTextures[9];
 SDL_Texture* gTexturePackage = NULL;
 SDL_Texture* gTextureBullet = NULL;
+struct starfield gStarfield;
 Mix_Music* menu;
 Mix_Music* game;
 Mix_Music* game_over;
 Mix_Chunk* sound;
 TTF_Font* font;
 
-//Counter of asteroids
-int asteroids_count = 0;
-
-//Counter of bullets
-int bullets_count = 0;
-int bullets_available = 10;
-
-//Counter of packages
-int packages_count = 0;
+//Game shown on the screen
+struct world gWorld;
 
-//Quantity of asteroids
-#define asteroids_quantity 200
+//Asteroids of gWorld to draw in the next frame
+struct world_draw gDraw;
 
-//Quantity of bullets
-#define bullets_quantity 20
+//Last seconds of gWorld for rewinding, and whether it is being rewound now
+struct rewind gRewind;
+bool rewinding = false;
 
-//Quantity of packages
-#define package_quantity 5
+//Ship is flown by the autopilot, and whether games start without the menu
+bool autopilot = false;
+bool attractMode = false;
 
-//All asteroids to render
-struct asteroids
-{
-    SDL_FRect dim;
-    SDL_Texture* texture;
-    float speed;
-    bool visible;
-    int HP;
-    bool is_hit;
-    double rotation;
-    double angle;
-}all_asteroids[asteroids_quantity];
+//Window was closed during a game, without the menu that ends the program
+bool quitRequested = false;
 
-//All bullets to render
-SDL_Rect all_bullets[bullets_quantity];
+//Autopilot flew some of the current game, such a game doesn't go to the leaderboard
+bool autopilotPlayed = false;
 
-//All bullets to render
-SDL_Rect all_packages[package_quantity];
+//Course of the endless mode, games take asteroids from it when it is loaded
+struct course gCourse;
+bool courseLoaded = false;
 
-//Locks shot speed
-int between_shots = 0;
+//Gameplay is recorded to a video, and the time the game spends reading frames back for it
+bool capturing = false;
+struct profile captureProfile = {.name = "capture readback"};
 
-//Time
-unsigned int lastTime = 0, currentTime, prevtime = 0, menuTime;;
+//Quantity of particles
+#define particles_quantity 4096
 
-//Score
-int currentScore = 0;
+//All particles to render, every field has its own array so the update loop runs over plain floats
+struct particles
+{
+    float x[particles_quantity];
+    float y[particles_quantity];
+    float vx[particles_quantity];
+    float vy[particles_quantity];
+    float size[particles_quantity];
+    float life[particles_quantity];
+    float fade[particles_quantity];
+    Uint8 r[particles_quantity];
+    Uint8 g[particles_quantity];
+    Uint8 b[particles_quantity];
+}all_particles;
+
+//Counter of particles, live ones are always at the beginning of the arrays
+int particles_count = 0;
+
+//Vertices and indices for drawing all particles at once
+SDL_Vertex particle_vertices[particles_quantity * 4];
+int particle_indices[particles_quantity * 6];
 
 //level of difficulty
 int difficulty = 0;
 
+//Statistics of the current run, handed to the telemetry writer when the run ends
+struct telemetry_record session;
+
+//Performance counter at the start of previous frame
+Uint64 lastFrame = 0;
+
 //angle of rotation
 double default_angle = 0;
 
@@ -287,45 +375,175 @@ SDL_Texture* loadTexture(char* path)
     return newTexture;
 }
 
+SDL_Surface* loadSurface(char* path)
+{
+    SDL_Surface* loadedSurface = SDL_LoadBMP(path);
+    if (loadedSurface == NULL)
+    {
+        printf("Unable to load image %s! SDL Error: %s\n", path, SDL_GetError());
+        return NULL;
+    }
+
+    SDL_Surface* surface = SDL_ConvertSurfaceFormat(loadedSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loadedSurface);
+    if (surface == NULL)
+    {
+        printf("Unable to convert image %s! SDL Error: %s\n", path, SDL_GetError());
+        return NULL;
+    }
+
+    //White background becomes alpha, so scaling can't mix it into the edges
+    for (int y = 0; y < surface->h; y++)
+    {
+        Uint32* row = (Uint32*)((Uint8*)surface->pixels + y * surface->pitch);
+        for (int x = 0; x < surface->w; x++)
+        {
+            if ((row[x] & 0x00FFFFFF) == 0x00FFFFFF) row[x] = 0;
+            else row[x] |= 0xFF000000;
+        }
+    }
+    return surface;
+}
+
+SDL_Surface* scaleSurface(SDL_Surface* source, int size)
+{
+    SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (scaled == NULL) return NULL;
+
+    for (int y = 0; y < size; y++)
+    {
+        int top = y * source->h / size;
+        int bottom = SDL_max((y + 1) * source->h / size, top + 1);
+        Uint32* out = (Uint32*)((Uint8*)scaled->pixels + y * scaled->pitch);
+
+        for (int x = 0; x < size; x++)
+        {
+            int left = x * source->w / size;
+            int right = SDL_max((x + 1) * source->w / size, left + 1);
+
+            //Colors are weighted by alpha, transparent pixels only make the result more transparent
+            Uint32 a = 0, r = 0, g = 0, b = 0;
+            for (int sy = top; sy < bottom; sy++)
+            {
+                Uint32* row = (Uint32*)((Uint8*)source->pixels + sy * source->pitch);
+                for (int sx = left; sx < right; sx++)
+                {
+                    Uint32 pixel = row[sx];
+                    Uint32 alpha = pixel >> 24;
+                    a += alpha;
+                    r += (pixel >> 16 & 0xFF) * alpha;
+                    g += (pixel >> 8 & 0xFF) * alpha;
+                    b += (pixel & 0xFF) * alpha;
+                }
+            }
+
+            int count = (bottom - top) * (right - left);
+            if (a == 0) out[x] = 0;
+            else out[x] = (a / count) << 24 | (r / a) << 16 | (g / a) << 8 | (b / a);
+        }
+    }
+    return scaled;
+}
+
+bool loadMipmap(char* path, struct mipmap* mip)
+{
+    SDL_Surface* surface = loadSurface(path);
+    if (surface == NULL) return false;
+
+    //The first level is averaged straight from the image, every next one from the level before it
+    int level;
+    for (level = 0; level < mip_levels; level++)
+    {
+        SDL_Surface* scaled = scaleSurface(surface, MIP_SIZES[level]);
+        SDL_FreeSurface(surface);
+        surface = scaled;
+        if (surface == NULL)
+        {
+            printf("Unable to scale image %s! SDL Error: %s\n", path, SDL_GetError());
+            break;
+        }
+
+        mip->levels[level] = SDL_CreateTextureFromSurface(gRenderer, surface);
+        if (mip->levels[level] == NULL)
+        {
+            printf("Unable to create a texture from %s! SDL Error: %s\n", path, SDL_GetError());
+            break;
+        }
+        SDL_SetTextureBlendMode(mip->levels[level], SDL_BLENDMODE_BLEND);
+    }
+    if (surface != NULL) SDL_FreeSurface(surface);
+
+    //A texture with a missing level is not used at all
+    if (level < mip_levels)
+    {
+        for (int i = 0; i < level; i++)
+        {
+            SDL_DestroyTexture(mip->levels[i]);
+            mip->levels[i] = NULL;
+        }
+        return false;
+    }
+    return true;
+}
+
+SDL_Texture* mipmapLevel(struct mipmap* mip, float size)
+{
+    for (int i = mip_levels - 1; i > 0; i--)
+    {
+        if (MIP_SIZES[i] >= size) return mip->levels[i];
+    }
+    return mip->levels[0];
+}
+
 bool loadMedia()
 {
     //Loads all textures
     bool success = true;
     gTexturePlayer = loadTexture("images/statek.bmp");
-    gTextureAsteroid1 = loadTexture("images/asteroida1.bmp");
-    gTextureAsteroid2 = loadTexture("images/asteroida2.bmp");
-    gTextureAsteroid3 = loadTexture("images/asteroida3.bmp");
-    gTextureAsteroid4 = loadTexture("images/asteroida4.bmp");
-    gTextureAsteroid5 = loadTexture("images/asteroida5.bmp");
-    gTextureAsteroid6 = loadTexture("images/asteroida6.bmp");
-    gTextureAsteroid7 = loadTexture("images/asteroida7.bmp");
-    gTextureAsteroid8 = loadTexture("images/asteroida8.bmp");
-    gTextureAsteroid9 = loadTexture("images/asteroida9.bmp");
     gTexturePackage = loadTexture("images/package.bmp");
     gTextureBullet = loadTexture("images/bullet.bmp");
 
-    if (gTexturePlayer == NULL || gTextureAsteroid1 == NULL || gTextureAsteroid2 == NULL ||
-        gTextureAsteroid3 == NULL || gTextureAsteroid4 == NULL || gTextureAsteroid5 == NULL ||
-        gTextureAsteroid6 == NULL || gTextureAsteroid7 == NULL || gTextureAsteroid8 == NULL || gTextureAsteroid9 == NULL)
+    if (gTexturePlayer == NULL)
     {
         printf("Failed to load texture image!\n");
         success = false;
     }
-    //Creates list of textures
-    textureList[0] = gTextureAsteroid1;
-    textureList[1] = gTextureAsteroid2;
-    textureList[2] = gTextureAsteroid3;
-    textureList[3] = gTextureAsteroid4;
-    textureList[4] = gTextureAsteroid5;
-    textureList[5] = gTextureAsteroid6;
-    textureList[6] = gTextureAsteroid7;
-    textureList[7] = gTextureAsteroid8;
-    textureList[8] = gTextureAsteroid9;
+
+    //Asteroids are only ever drawn small, so they are kept as small levels only
+    for (int i = 0; i < 9; i++)
+    {
+        char path[32];
+        sprintf(path, "images/asteroida%d.bmp", i + 1);
+        if (!loadMipmap(path, &asteroidTextures[i]))
+        {
+            printf("Failed to load texture image!\n");
+            success = false;
+        }
+    }
+
+    //Without stars the background is only cleared, so the game can go on
+    starfieldInit(&gStarfield, gRenderer, STARFIELD_SEED, SCREEN_WIDTH, SCREEN_HEIGHT);
     return success;
 }
 
-void close()
+void closeSDL()
 {
+    //Write remaining telemetry
+    telemetryQuit();
+    leaderboardQuit();
+    autopilotQuit();
+    spectatorQuit();
+    if (courseLoaded) courseClose(&gCourse);
+    if (capturing)
+    {
+        captureStop();
+        struct capture_stats stats = captureStats();
+        printf("video: %d frames written, %d dropped\n", stats.written, stats.dropped);
+        profilePrint(&captureProfile);
+    }
+    capturing = false;
+    courseLoaded = false;
+
     //Destroy music and sound
     Mix_FreeMusic( game );
     Mix_FreeMusic( game_over );
@@ -333,13 +551,16 @@ void close()
 
     //Destroy texture
     SDL_DestroyTexture(gTexturePlayer);
-    SDL_DestroyTexture(gTextureAsteroid1);
-    SDL_DestroyTexture(gTextureAsteroid2);
-    SDL_DestroyTexture(gTextureAsteroid3);
     gTexturePlayer = NULL;
-    gTextureAsteroid1 = NULL;
-    gTextureAsteroid2 = NULL;
-    gTextureAsteroid3 = NULL;
+    for (int i = 0; i < 9; i++)
+    {
+        for (int j = 0; j < mip_levels; j++)
+        {
+            SDL_DestroyTexture(asteroidTextures[i].levels[j]);
+            asteroidTextures[i].levels[j] = NULL;
+        }
+    }
+    starfieldFree(&gStarfield);
 
     //Destroy window
     SDL_DestroyRenderer(gRenderer);
@@ -353,95 +574,64 @@ void close()
     SDL_Quit();
 }
 
-SDL_FRect keyboardCheck(SDL_FRect player)
+struct world_input keyboardCheck()
 {
-    //Check for user input and move player/close program
+    //Check for user input
 
     const Uint8* keyboardstate = SDL_GetKeyboardState(NULL);
-    float speed = PLAYER_SPEED;
-    if((keyboardstate[SDL_SCANCODE_UP]|| keyboardstate[SDL_SCANCODE_DOWN]) && (keyboardstate[SDL_SCANCODE_RIGHT] || keyboardstate[SDL_SCANCODE_LEFT])) speed = sqrt(speed);
-    //First condition checks input && second condition keeps player in the playable area
-    if (keyboardstate[SDL_SCANCODE_UP] && player.y > SCREEN_HEIGHT / 2) player.y -= speed;
-    if (keyboardstate[SDL_SCANCODE_DOWN] && player.y + PLAYER_HEIGHT <= SCREEN_HEIGHT) player.y += speed;
-    if (keyboardstate[SDL_SCANCODE_LEFT] && player.x > 0) player.x -= speed;
-    if (keyboardstate[SDL_SCANCODE_RIGHT] && player.x + PLAYER_WIDTH <= SCREEN_WIDTH) player.x += speed;
-    if (keyboardstate[SDL_SCANCODE_SPACE] && between_shots == 0 && bullets_available != 0)
-    {
-        createBullet(player);
-        between_shots = BULLET_COOLDOWN;
-        Mix_PlayChannel( -1, sound, 0 );
-    }
-
-    return player;
-}
-
-void createAsteoid()
-{
-    // Create asteroid(rectangle) with random parameters and add them to global array
-    int xy = rand() % 70 + 30;
-    SDL_FRect asteroid = { rand() % 1000, -rand() % 100 - 100, xy, xy};
-    all_asteroids[asteroids_count].dim = asteroid;
-    all_asteroids[asteroids_count].speed = (rand()%501 + 900)/1000.0;
-    all_asteroids[asteroids_count].visible = true;
-    all_asteroids[asteroids_count].texture = textureList[rand() % 9];
-    if(xy > 70) all_asteroids[asteroids_count].HP = 2;
-    else all_asteroids[asteroids_count].HP = 1;
-    all_asteroids[asteroids_count].is_hit=false;
-    all_asteroids[asteroids_count].angle = rand()%360 + 1;
-    all_asteroids[asteroids_count].rotation = (rand()%40 + 1)/100.0;
-    if(asteroids_count == asteroids_quantity / 20)   createPackage();
-    asteroids_count++;
-    asteroids_count %= asteroids_quantity;
+    struct world_input input;
+    input.up = keyboardstate[SDL_SCANCODE_UP];
+    input.down = keyboardstate[SDL_SCANCODE_DOWN];
+    input.left = keyboardstate[SDL_SCANCODE_LEFT];
+    input.right = keyboardstate[SDL_SCANCODE_RIGHT];
+    input.fire = keyboardstate[SDL_SCANCODE_SPACE];
+
+    return input;
 }
 
-void createBullet(SDL_FRect player)
+void render()
 {
-    // Create bullet(square) and add them to global array
-
-    SDL_Rect bullet = { (player.x + PLAYER_WIDTH / 2 - 5), player.y, BULLET_WIDTH, BULLET_HEIGHT };
-    all_bullets[bullets_count] = bullet;
-    bullets_count++;
-    bullets_count %= bullets_quantity;
-    bullets_available--;
-}
-
-void createPackage()
-{
-    SDL_Rect package = {rand() % SCREEN_WIDTH, -rand() % 100 - 100, 75, 75};
-    all_packages[packages_count] = package;
-    packages_count++;
-    packages_count %= package_quantity;
-}
-
-void render(SDL_FRect player)
-{
-    //Clears screen
-    SDL_SetRenderDrawColor(gRenderer, 96, 128, 255, 255);
-    SDL_RenderClear(gRenderer);
+    //Stars cover the whole screen, it is cleared only when there are none
+    if (!starfieldRender(&gStarfield, gRenderer, gWorld.clock))
+    {
+        SDL_SetRenderDrawColor(gRenderer, 96, 128, 255, 255);
+        SDL_RenderClear(gRenderer);
+    }
 
     //render asteroid
     asteroids_render();
 
+    //render particles
+    particles_render();
+
     //render bullets
     for(int i = 0; i < bullets_quantity; i++)
     {
-        SDL_RenderCopy(gRenderer, gTextureBullet, NULL, &all_bullets[i]);
+        SDL_RenderCopy(gRenderer, gTextureBullet, NULL, &gWorld.all_bullets[i]);
     }
 
     //render packages
     for(int i = 0; i < package_quantity; i++)
     {
-        SDL_RenderCopy(gRenderer, gTexturePackage, NULL, &all_packages[i]);
+        SDL_RenderCopy(gRenderer, gTexturePackage, NULL, &gWorld.all_packages[i]);
     }
 
     render_scoreboard();
 
     //Render texture to screen
-    SDL_RenderCopyF(gRenderer, gTexturePlayer, NULL, &player);
+    SDL_RenderCopyF(gRenderer, gTexturePlayer, NULL, &gWorld.player);
 
     SDL_SetRenderDrawColor(gRenderer, 255, 0, 0, 128);
     SDL_RenderDrawLine(gRenderer, 0, SCREEN_HEIGHT / 2, SCREEN_WIDTH, SCREEN_HEIGHT / 2);
 
+    //Frame has to be read before it is presented
+    if (capturing)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        captureFrame(gRenderer, SDL_GetTicks());
+        profileAdd(&captureProfile, start);
+    }
+
     //Update screen
     SDL_RenderPresent(gRenderer);
 }
@@ -450,20 +640,136 @@ void asteroids_render()
 {
     SDL_RendererFlip flip = SDL_FLIP_HORIZONTAL | SDL_FLIP_VERTICAL;
 
-    if ((currentTime - prevtime) > 300 - 50*difficulty - (currentTime-menuTime)/1000 )
+    //Only asteroids from the draw list, the step already left out the ones that can't be seen
+    for (int i = 0; i < gDraw.asteroids_count; i++)
     {
-        createAsteoid();
-        prevtime = currentTime;
+        struct asteroid_draw* asteroid = &gDraw.asteroids[i];
+        SDL_Texture* texture = mipmapLevel(&asteroidTextures[asteroid->texture], asteroid->dim.w);
+        if(asteroid->is_hit == true) SDL_SetTextureAlphaMod(texture,170);
+        SDL_RenderCopyExF(gRenderer,texture, NULL, &asteroid->dim , default_angle + asteroid->angle ,NULL, flip);
+        SDL_SetTextureAlphaMod(texture,255);
     }
+    default_angle+=0.1;
+}
 
-    for (int i = 0; i < asteroids_quantity; i++)
+void particlesInit()
+{
+    //Every particle is a quad made of two triangles, indices never change so they are set once
+    for (int i = 0; i < particles_quantity; i++)
     {
-        if(all_asteroids[i].is_hit == true) SDL_SetTextureAlphaMod(all_asteroids[i].texture,170);
-        SDL_RenderCopyExF(gRenderer,all_asteroids[i].texture, NULL, &all_asteroids[i].dim , default_angle + all_asteroids[i].angle ,NULL, flip);
-        SDL_SetTextureAlphaMod(all_asteroids[i].texture,255);
-        all_asteroids[i].angle+=all_asteroids[i].rotation;
+        particle_indices[i * 6 + 0] = i * 4 + 0;
+        particle_indices[i * 6 + 1] = i * 4 + 1;
+        particle_indices[i * 6 + 2] = i * 4 + 2;
+        particle_indices[i * 6 + 3] = i * 4 + 2;
+        particle_indices[i * 6 + 4] = i * 4 + 3;
+        particle_indices[i * 6 + 5] = i * 4 + 0;
     }
-    default_angle+=0.1;
+    particles_count = 0;
+}
+
+void createParticles(float x, float y, int count, bool debris)
+{
+    //When the pool is full new particles are skipped
+    for (int k = 0; k < count && particles_count < particles_quantity; k++)
+    {
+        int i = particles_count;
+        float direction = (rand() % 360) * M_PI / 180.0;
+        float speed;
+
+        all_particles.x[i] = x;
+        all_particles.y[i] = y;
+        all_particles.life[i] = 1;
+        if (debris)
+        {
+            speed = (rand() % 120 + 30) / 100.0;
+            all_particles.size[i] = rand() % 4 + 3;
+            all_particles.fade[i] = 1.0 / (rand() % 80 + 80);
+            all_particles.r[i] = rand() % 40 + 110;
+            all_particles.g[i] = all_particles.r[i] - 20;
+            all_particles.b[i] = all_particles.r[i] - 40;
+        }
+        else
+        {
+            speed = (rand() % 250 + 150) / 100.0;
+            all_particles.size[i] = 2;
+            all_particles.fade[i] = 1.0 / (rand() % 20 + 20);
+            all_particles.r[i] = 255;
+            all_particles.g[i] = rand() % 76 + 180;
+            all_particles.b[i] = 64;
+        }
+        all_particles.vx[i] = cos(direction) * speed;
+        all_particles.vy[i] = sin(direction) * speed;
+        particles_count++;
+    }
+}
+
+void particlesUpdate()
+{
+    int n = particles_count;
+    float* restrict x = all_particles.x;
+    float* restrict y = all_particles.y;
+    float* restrict vx = all_particles.vx;
+    float* restrict vy = all_particles.vy;
+    float* restrict life = all_particles.life;
+    const float* restrict fade = all_particles.fade;
+
+    //No branches here so the compiler can do several particles per instruction
+    for (int i = 0; i < n; i++)
+    {
+        x[i] += vx[i];
+        y[i] += vy[i];
+        vx[i] *= PARTICLE_DRAG;
+        vy[i] = vy[i] * PARTICLE_DRAG + PARTICLE_GRAVITY;
+        life[i] -= fade[i];
+    }
+
+    //Faded particle is replaced by the last live one
+    for (int i = 0; i < n;)
+    {
+        if (life[i] > 0)
+        {
+            i++;
+            continue;
+        }
+        n--;
+        all_particles.x[i] = all_particles.x[n];
+        all_particles.y[i] = all_particles.y[n];
+        all_particles.vx[i] = all_particles.vx[n];
+        all_particles.vy[i] = all_particles.vy[n];
+        all_particles.size[i] = all_particles.size[n];
+        all_particles.life[i] = all_particles.life[n];
+        all_particles.fade[i] = all_particles.fade[n];
+        all_particles.r[i] = all_particles.r[n];
+        all_particles.g[i] = all_particles.g[n];
+        all_particles.b[i] = all_particles.b[n];
+    }
+    particles_count = n;
+}
+
+void particles_render()
+{
+    if (particles_count == 0) return;
+
+    for (int i = 0; i < particles_count; i++)
+    {
+        float half = all_particles.size[i] / 2;
+        SDL_Color color = {all_particles.r[i], all_particles.g[i], all_particles.b[i], (Uint8)(all_particles.life[i] * 255)};
+        SDL_Vertex* v = &particle_vertices[i * 4];
+
+        v[0].position.x = all_particles.x[i] - half;
+        v[0].position.y = all_particles.y[i] - half;
+        v[1].position.x = all_particles.x[i] + half;
+        v[1].position.y = all_particles.y[i] - half;
+        v[2].position.x = all_particles.x[i] + half;
+        v[2].position.y = all_particles.y[i] + half;
+        v[3].position.x = all_particles.x[i] - half;
+        v[3].position.y = all_particles.y[i] + half;
+        v[0].color = v[1].color = v[2].color = v[3].color = color;
+    }
+
+    SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometry(gRenderer, NULL, particle_vertices, particles_count * 4, particle_indices, particles_count * 6);
+    SDL_SetRenderDrawBlendMode(gRenderer, SDL_BLENDMODE_NONE);
 }
 
 void render_scoreboard()
@@ -474,7 +780,7 @@ void render_scoreboard()
 
     char* str = (char*)malloc(50*sizeof(char));
 
-    if(sprintf(str,"Time: %d   Score: %d   Bullets: %d", (currentTime-menuTime)/1000, currentScore, bullets_available)<0)
+    if(sprintf(str,"Time: %d   Score: %d   Bullets: %d", (gWorld.currentTime-gWorld.menuTime)/1000, gWorld.currentScore, gWorld.bullets_available)<0)
         str="Failed to load text";
 
     text = TTF_RenderText_Solid( font, str, color );
@@ -499,79 +805,6 @@ void render_scoreboard()
     SDL_DestroyTexture(text_texture);
 }
 
-SDL_Rect convert(SDL_FRect frect)
-{
-    SDL_Rect rect;
-
-    rect.h = (int)frect.h;
-    rect.w = (int)frect.w;
-    rect.x = (int)frect.x;
-    rect.y = (int)frect.y;
-    return rect;
-}
-
-bool collisionCheckAsteroid(SDL_FRect player)
-{
-    SDL_Rect player_rect = convert(player);
-    //Use SDL_HasIntersection to see if asteroid collides with player
-    for (int i = 0; i < asteroids_quantity; i++)
-    {
-        SDL_Rect rect = convert(all_asteroids[i].dim);
-
-        if (SDL_HasIntersection(&player_rect, &rect))
-        {
-            return false;
-        }
-        if (collisionCheckBullet(i) == false  && all_asteroids[i].HP == 0)
-        {
-            //If asteroid collides with bullet, change asteroid size to 0 and change position to player's y to get a point
-            all_asteroids[i].dim.h = 0;
-            all_asteroids[i].dim.w = 0;
-            all_asteroids[i].dim.x = 0;
-            all_asteroids[i].dim.y = player.y-1;
-        }
-    }
-
-    return true;
-}
-
-bool collisionCheckBullet(int j)
-{
-    SDL_Rect rect = convert(all_asteroids[j].dim);
-    //Use SDL_HasIntersection to see if bullet collides with asteroid and delete them if so
-    for (int i = 0; i < bullets_quantity; i++)
-    {
-        if (SDL_HasIntersection(&rect, &all_bullets[i]))
-        {
-            all_asteroids[j].HP--;
-            all_asteroids[j].is_hit = true;
-            all_bullets[i].h = 0;
-            all_bullets[i].w = 0;
-            all_bullets[i].x = 0;
-            all_bullets[i].y = 0;
-            return false;
-        }
-    }
-    return true;
-}
-
-bool collisionCheckPackage(SDL_FRect player)
-{
-    SDL_Rect player_rect = convert(player);
-    for(int i = 0; i < packages_count; i++)
-    {
-        if(SDL_HasIntersection(&player_rect, &all_packages[i]))
-        {
-            all_packages[i].w = 0;
-            all_packages[i].h = 0;
-            all_packages[i].x = 0;
-            all_packages[i].y = 0;
-            return false;
-        }
-    }
-    return true;
-}
-
 void gameOver(SDL_Event e)
 {
     //Create a game over screen(I have to add some text to it)
@@ -582,37 +815,61 @@ void gameOver(SDL_Event e)
 
     SDL_Surface* text1;
     SDL_Surface* text2;
+    SDL_Surface* text3;
     // Set color to white
     SDL_Color color = {0, 0, 0, 255};
-    prevtime=currentTime;
-    while(currentTime - prevtime < 4000)
+    unsigned int overTime = gWorld.currentTime;
+
+    //Run goes to the leaderboard writer, its place is shown as soon as the writer lets go of the leaderboard.
+    //Games the autopilot took part in aren't ranked, they would push players out of the top runs
+    struct leaderboard_record run = {0};
+    run.score = gWorld.currentScore;
+    run.duration_ms = overTime - gWorld.menuTime;
+    run.difficulty = gWorld.difficulty;
+    run.source = LEADERBOARD_GAME;
+    run.time = time(NULL);
+    leaderboardSeal(&run);
+    bool waiting = !autopilotPlayed && leaderboardSubmit(&run);
+    uint64_t place = 0, total = 0;
+    while(gWorld.currentTime - overTime < 4000)
     {
         SDL_RenderClear(gRenderer);
-        currentTime = SDL_GetTicks();
+        gWorld.currentTime = SDL_GetTicks();
         SDL_PollEvent(&e);
         char* str = (char*)malloc(50*sizeof(char));
 
-        if(sprintf(str,"Time: %d   Score: %d", (prevtime-menuTime)/1000, currentScore)<0)
+        if(sprintf(str,"Time: %d   Score: %d", (overTime-gWorld.menuTime)/1000, gWorld.currentScore)<0)
             str="Failed to load text";
 
+        if (waiting && leaderboardPlace(run.score, &place, &total)) waiting = false;
+        char placeText[50] = " ";
+        if (place > 0) sprintf(placeText, "Place: %llu of %llu", (unsigned long long)place, (unsigned long long)total);
+        else if (autopilotPlayed) sprintf(placeText, "Autopilot: not ranked");
+        else if (!waiting) sprintf(placeText, "Place: not saved");
+
         text1 = TTF_RenderText_Solid( font, "GAME OVER", color );
         text2 = TTF_RenderText_Solid( font, str, color );
+        text3 = TTF_RenderText_Solid( font, placeText, color );
 
-        if ( !text1 || !text2)
+        if ( !text1 || !text2 || !text3)
         {
             printf("Failed to render text: %s", TTF_GetError());
         }
 
         SDL_Texture* text_texture1;
         SDL_Texture* text_texture2;
+        SDL_Texture* text_texture3;
         text_texture1 = SDL_CreateTextureFromSurface( gRenderer, text1 );
         text_texture2 = SDL_CreateTextureFromSurface( gRenderer, text2 );
+        text_texture3 = SDL_CreateTextureFromSurface( gRenderer, text3 );
         SDL_Rect dest1 = {(SCREEN_WIDTH - text1->w)/2, SCREEN_HEIGHT/2, text1->w, text1->h };
         SDL_Rect dest2 = {(SCREEN_WIDTH - text2->w)/2 , SCREEN_HEIGHT/2 + text1->h, text2->w, text2->h };
+        SDL_Rect dest3 = {(SCREEN_WIDTH - text3->w)/2 , SCREEN_HEIGHT/2 + text1->h + text2->h, text3->w, text3->h };
 
         //render text
         SDL_RenderCopy( gRenderer, text_texture1, NULL, &dest1 );
         SDL_RenderCopy( gRenderer, text_texture2, NULL, &dest2 );
+        SDL_RenderCopy( gRenderer, text_texture3, NULL, &dest3 );
 
         SDL_RenderPresent(gRenderer);
 
@@ -620,87 +877,100 @@ void gameOver(SDL_Event e)
         free(str);
         SDL_FreeSurface(text1);
         SDL_FreeSurface(text2);
+        SDL_FreeSurface(text3);
         SDL_DestroyTexture(text_texture1);
         SDL_DestroyTexture(text_texture2);
+        SDL_DestroyTexture(text_texture3);
 
-        if(e.type == SDL_QUIT) close();
-    }
-}
-
-void asteroidBulletAndPackageMovement()
-{
-    for(int i = 0; i < package_quantity; i++)
-    {
-        all_packages[i].y += PACKAGE_SPEED;
-    }
-    for(int i = 0; i < asteroids_quantity; i++)
-    {
-        all_asteroids[i].dim.y += (all_asteroids[i].speed + ((float)(currentTime-menuTime))/20000.0);
-    }
-    for(int i = 0; i < bullets_quantity; i++)
-    {
-        all_bullets[i].y -= BULLET_SPEED;
-    }
-}
-
-void getScore(SDL_FRect player)
-{
-    //Looks at all asteroids and if player is higher than asteroid then it adds one to the score
-    for (int i = 0; i < asteroids_quantity; i++)
-    {
-        if (player.y < all_asteroids[i].dim.y && all_asteroids[i].visible == true)
+        if(e.type == SDL_QUIT)
         {
-            currentScore++;
-            all_asteroids[i].visible = false;
+            //Attract mode closes everything once the game loop has ended
+            if (attractMode)
+            {
+                quitRequested = true;
+                break;
+            }
+            closeSDL();
         }
     }
 }
 
-bool gameLoop(SDL_Event e, SDL_FRect *player_pointer)
+bool gameLoop(SDL_Event e)
 {
-    SDL_FRect player = *player_pointer;
+    //Frame statistics for telemetry
+    Uint64 frameStart = SDL_GetPerformanceCounter();
+    double frame_ms = (frameStart - lastFrame) * 1000.0 / SDL_GetPerformanceFrequency();
+    telemetryAddFrame(&session, frame_ms);
+    lastFrame = frameStart;
+    //Draw list of the last step already holds every asteroid on the screen
+    Uint32 live = gDraw.asteroids_count;
+    if (live > session.peak_asteroids) session.peak_asteroids = live;
     //Handle events on queue
     SDL_PollEvent(&e);
 
     //User requests quit
-    if (e.type == SDL_QUIT) return false;
-    if(SDL_GetKeyboardState(NULL)[SDL_SCANCODE_ESCAPE]) return false;
+    if (e.type == SDL_QUIT || SDL_GetKeyboardState(NULL)[SDL_SCANCODE_ESCAPE])
+    {
+        if (attractMode) quitRequested = true;
+        return false;
+    }
+    if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_a) autopilot = !autopilot;
+
+    //Holding R plays the last seconds backwards
+    if (SDL_GetKeyboardState(NULL)[SDL_SCANCODE_R])
+    {
+        if (!rewinding) particles_count = 0;
+        rewinding = true;
+        rewindRestore(&gRewind, &gWorld);
+        worldDrawList(&gWorld, &gDraw);
+        spectatorPublish(&gWorld, &gDraw);
+        render();
+        return true;
+    }
+    if (rewinding)
+    {
+        worldResume(&gWorld, SDL_GetTicks());
+        rewinding = false;
+    }
 
     //player movement
     if (e.type != SDL_MOUSEMOTION)
     {
-        player = keyboardCheck(player);
-
-        asteroidBulletAndPackageMovement();
+        //Autopilot plays ahead with the length of the last frame
+        struct world_input input;
+        if (autopilot) input = autopilotChoose(&gWorld, frame_ms + 0.5, AUTOPILOT_BUDGET_MS);
+        else input = keyboardCheck();
+        autopilotPlayed = autopilotPlayed || autopilot;
 
-        if (collisionCheckAsteroid(player))
-        {
-            render(player);
-            if(!collisionCheckPackage(player))
-            {
-                bullets_available += 10;
-            }
-        }
-        else
+        if (!worldStep(&gWorld, input, &gDraw))
         {
             gameOver(e);
             return 0;
         }
-    }
+        rewindSave(&gRewind, &gWorld);
 
-    //show score
-    getScore(player);
+        if (gWorld.fired) Mix_PlayChannel( -1, sound, 0 );
 
-    //show time
-    currentTime = SDL_GetTicks();
-    if (currentTime > lastTime + 1000)
-    {
-        lastTime = currentTime;
+        //Sparks for every hit and debris for destroyed asteroids
+        for (int i = 0; i < gWorld.hits_count; i++)
+        {
+            struct world_hit* hit = &gWorld.hits[i];
+            if (hit->destroyed) createParticles(hit->x, hit->y, hit->size, true);
+            else createParticles(hit->x, hit->y, 12, false);
+        }
+        particlesUpdate();
 
-        if (between_shots != 0) between_shots--;
+        spectatorPublish(&gWorld, &gDraw);
+        render();
     }
 
-    *player_pointer=player;
+    //show time
+    worldTick(&gWorld, SDL_GetTicks());
+    session.duration_ms = gWorld.currentTime - gWorld.menuTime;
+
+    //Chunks of the course ahead are read while this frame waits
+    if (gWorld.course != NULL) courseStream(&gCourse, gWorld.clock - gWorld.course_start);
+
     return true;
 }
 
@@ -730,10 +1000,11 @@ void menu_render(SDL_Event e)
         SDL_SetRenderDrawColor(gRenderer, 108, 255, 235, 0);
         SDL_RenderFillRect(gRenderer, &background);
 
+        worldDrawList(&gWorld, &gDraw);
         asteroids_render();
-        asteroidBulletAndPackageMovement();
+        asteroidBulletAndPackageMovement(&gWorld);
 
-        currentTime = SDL_GetTicks();
+        worldTick(&gWorld, SDL_GetTicks());
 
         //Handle events on queue
         SDL_PollEvent(&e);
@@ -813,7 +1084,7 @@ void menu_render(SDL_Event e)
         SDL_Delay(10);
     }
 
-    close();
+    closeSDL();
 }
 
 void option_render(SDL_Event e)
@@ -839,10 +1110,11 @@ void option_render(SDL_Event e)
         SDL_SetRenderDrawColor(gRenderer, 108, 255, 235, 0);
         SDL_RenderFillRect(gRenderer, &background);
 
+        worldDrawList(&gWorld, &gDraw);
         asteroids_render();
-        asteroidBulletAndPackageMovement();
+        asteroidBulletAndPackageMovement(&gWorld);
 
-        currentTime = SDL_GetTicks();
+        worldTick(&gWorld, SDL_GetTicks());
 
         //Handle events on queue
         SDL_PollEvent(&e);
@@ -948,7 +1220,536 @@ void option_render(SDL_Event e)
         free(str[i]);
         free(choice[i]);
     }
-    close();
+    closeSDL();
+}
+void profileAdd(struct profile* p, Uint64 start)
+{
+    Uint64 elapsed = SDL_GetPerformanceCounter() - start;
+
+    p->total += elapsed;
+    if (elapsed > p->worst) p->worst = elapsed;
+    p->samples++;
+}
+
+void profilePrint(struct profile* p)
+{
+    double ms = SDL_GetPerformanceFrequency() / 1000.0;
+
+    if (p->samples == 0) return;
+    printf("%-20s avg %7.3f ms   worst %7.3f ms", p->name, p->total / ms / p->samples, p->worst / ms);
+    if (p->misses > 0) printf("   %10.0f cache misses", (double)p->misses / p->samples);
+    printf("\n");
+}
+
+int cacheCounterOpen()
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+long long cacheCounterRead(int counter)
+{
+    long long misses = 0;
+#ifdef __linux__
+    if (counter >= 0 && read(counter, &misses, sizeof(misses)) != sizeof(misses)) misses = 0;
+#endif
+    return misses;
+}
+
+void benchmarkAsteroids(int count, int counter)
+{
+    struct profile passes = {.name = "separate passes"};
+    struct profile fused = {.name = "fused pass"};
+    struct asteroid* field[2];
+    struct asteroid_draw* draw = malloc(count * sizeof(struct asteroid_draw));
+    struct world worlds[2];
+    struct world setup;
+
+    field[0] = malloc(count * sizeof(struct asteroid));
+    field[1] = malloc(count * sizeof(struct asteroid));
+    if (field[0] == NULL || field[1] == NULL || draw == NULL)
+    {
+        printf("Not enough memory for %d asteroids!\n", count);
+        free(field[0]);
+        free(field[1]);
+        free(draw);
+        return;
+    }
+
+    //Asteroids fill the screen and four screens above it, the player is moved aside so nobody dies
+    worldInit(&setup, 1, 1, 0);
+    for (int i = 0; i < count; i++)
+    {
+        int slot = setup.asteroids_count;
+        createAsteoid(&setup);
+        field[0][i] = setup.all_asteroids[slot];
+        field[0][i].dim.x = worldRand(&setup) % SCREEN_WIDTH;
+        field[0][i].dim.y = worldRand(&setup) % (SCREEN_HEIGHT * 5) - SCREEN_HEIGHT * 4;
+    }
+    memcpy(field[1], field[0], count * sizeof(struct asteroid));
+    setup.player.x = -SCREEN_WIDTH;
+    worlds[0] = setup;
+    worlds[1] = setup;
+
+    //Same amount of asteroid steps for every size
+    int ticks = SDL_clamp(20000000 / count, 20, BENCHMARK_FRAMES);
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        //Both get the same fresh bullets, so both have hits to handle
+        for (int i = 0; i < bullets_quantity; i++)
+        {
+            SDL_Rect bullet = {worldRand(&setup) % SCREEN_WIDTH, worldRand(&setup) % SCREEN_HEIGHT, BULLET_WIDTH, BULLET_HEIGHT};
+            worlds[0].all_bullets[i] = bullet;
+            worlds[1].all_bullets[i] = bullet;
+        }
+
+        for (int variant = 0; variant < 2; variant++)
+        {
+            struct world* w = &worlds[variant];
+            struct profile* p = variant == 0 ? &passes : &fused;
+            w->hits_count = 0;
+            w->currentTime += 7;
+
+            long long misses = cacheCounterRead(counter);
+            Uint64 start = SDL_GetPerformanceCounter();
+            if (variant == 0)
+            {
+                //What a step and the renderer did before: every job walks the whole array again
+                asteroidMovement(w, field[0], count);
+                collisionCheckAsteroid(w, field[0], count);
+                getScore(w, field[0], count);
+                asteroidsDrawList(field[0], count, draw);
+            }
+            else asteroidsUpdate(w, field[1], count, draw);
+            profileAdd(p, start);
+            p->misses += cacheCounterRead(counter) - misses;
+        }
+    }
+
+    printf("asteroid step: %d asteroids, %d ticks, %d bytes each\n", count, ticks, (int)sizeof(struct asteroid));
+    profilePrint(&passes);
+    profilePrint(&fused);
+
+    free(field[0]);
+    free(field[1]);
+    free(draw);
+}
+
+void benchmarkParticles()
+{
+    struct profile particle_update = {.name = "particle update"};
+    struct profile particle_draw = {.name = "particle draw"};
+    int particles_peak = 0;
+
+    particlesInit();
+    for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+    {
+        while (particles_count < particles_quantity - 100)
+        {
+            createParticles(rand() % SCREEN_WIDTH, rand() % SCREEN_HEIGHT, 100, true);
+            createParticles(rand() % SCREEN_WIDTH, rand() % SCREEN_HEIGHT, 12, false);
+        }
+        if (particles_count > particles_peak) particles_peak = particles_count;
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        particlesUpdate();
+        profileAdd(&particle_update, start);
+
+        SDL_SetRenderDrawColor(gRenderer, 96, 128, 255, 255);
+        SDL_RenderClear(gRenderer);
+        start = SDL_GetPerformanceCounter();
+        particles_render();
+        SDL_RenderFlush(gRenderer);
+        profileAdd(&particle_draw, start);
+        SDL_RenderPresent(gRenderer);
+    }
+
+    printf("particles: %d frames, up to %d live\n", BENCHMARK_FRAMES, particles_peak);
+    profilePrint(&particle_update);
+    profilePrint(&particle_draw);
+    double particle_ms = (double)(particle_update.total + particle_draw.total) / BENCHMARK_FRAMES / (SDL_GetPerformanceFrequency() / 1000.0);
+    printf("particles per frame  %7.3f ms (budget 1 ms) %s\n", particle_ms, particle_ms <= 1 ? "OK" : "OVER");
+}
+
+bool benchmarkRewind()
+{
+    struct profile rewind_save = {.name = "rewind snapshot"};
+    struct profile rewind_restore = {.name = "rewind restore"};
+    struct rewind history;
+
+    if (!rewindInit(&history))
+    {
+        printf("Not enough memory for rewinding!\n");
+        return false;
+    }
+    worldInit(&gWorld, 1, 1, 0);
+    for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+    {
+        struct world_input input = {false, frame % 200 < 20, frame % 120 < 60, frame % 120 >= 60, true};
+        if (!worldStep(&gWorld, input, NULL)) worldInit(&gWorld, 1, frame + 1, gWorld.currentTime);
+        worldTick(&gWorld, gWorld.currentTime + 7);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        rewindSave(&history, &gWorld);
+        profileAdd(&rewind_save, start);
+    }
+    double history_seconds = (history.count - 1) * 7 / 1000.0;
+    size_t history_bytes = rewindBytes(&history);
+    int snapshots = history.count;
+    while (true)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        if (!rewindRestore(&history, &gWorld)) break;
+        profileAdd(&rewind_restore, start);
+    }
+    rewindFree(&history);
+
+    printf("rewind: %d snapshots of %d bytes, %.0f kB per second of history\n", snapshots, (int)sizeof(struct world),
+           history_bytes / history_seconds / 1024);
+    profilePrint(&rewind_save);
+    profilePrint(&rewind_restore);
+    return true;
+}
+
+void benchmarkAutopilot()
+{
+    struct profile autopilot_decision = {.name = "autopilot decision"};
+
+    autopilotInit(0);
+    worldInit(&gWorld, 1, 1, 0);
+    for (int frame = 0; frame < BENCHMARK_FRAMES / 4; frame++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        struct world_input input = autopilotChoose(&gWorld, 7, AUTOPILOT_BUDGET_MS);
+        profileAdd(&autopilot_decision, start);
+
+        if (!worldStep(&gWorld, input, NULL)) worldInit(&gWorld, 1, frame + 1, gWorld.currentTime);
+        worldTick(&gWorld, gWorld.currentTime + 7);
+    }
+    struct autopilot_stats stats = autopilotStats();
+
+    printf("autopilot: %d candidates x %d steps, %d rollouts done, %d over budget, %.0f simulated steps per second\n",
+           autopilot_candidates_quantity, AUTOPILOT_HORIZON, stats.rollouts, stats.skipped,
+           stats.steps / ((double)stats.time / SDL_GetPerformanceFrequency()));
+    profilePrint(&autopilot_decision);
+}
+
+void benchmarkAsteroidTextures()
+{
+    struct profile asteroid_full = {.name = "asteroids original"};
+    struct profile asteroid_mip = {.name = "asteroids scaled"};
+    SDL_Texture* original[9];
+    int original_bytes = 0;
+    int mip_bytes = 0;
+
+    for (int i = 0; i < 9; i++)
+    {
+        char path[32];
+        int w, h;
+        sprintf(path, "images/asteroida%d.bmp", i + 1);
+        original[i] = loadTexture(path);
+        SDL_QueryTexture(original[i], NULL, NULL, &w, &h);
+        original_bytes += w * h * 4;
+        for (int j = 0; j < mip_levels; j++) mip_bytes += MIP_SIZES[j] * MIP_SIZES[j] * 4;
+    }
+    worldInit(&gWorld, 1, 1, 0);
+    for (int i = 0; i < asteroids_quantity; i++)
+    {
+        createAsteoid(&gWorld);
+        gWorld.all_asteroids[i].dim.y = worldRand(&gWorld) % SCREEN_HEIGHT;
+    }
+    for (int frame = 0; frame < BENCHMARK_FRAMES / 4; frame++)
+    {
+        for (int pass = 0; pass < 2; pass++)
+        {
+            SDL_SetRenderDrawColor(gRenderer, 96, 128, 255, 255);
+            SDL_RenderClear(gRenderer);
+            Uint64 start = SDL_GetPerformanceCounter();
+            for (int i = 0; i < asteroids_quantity; i++)
+            {
+                struct asteroid* asteroid = &gWorld.all_asteroids[i];
+                SDL_Texture* texture = pass == 0 ? original[asteroid->texture] : mipmapLevel(&asteroidTextures[asteroid->texture], asteroid->dim.w);
+                SDL_RenderCopyExF(gRenderer, texture, NULL, &asteroid->dim, asteroid->angle, NULL, SDL_FLIP_NONE);
+            }
+            SDL_RenderFlush(gRenderer);
+            profileAdd(pass == 0 ? &asteroid_full : &asteroid_mip, start);
+            SDL_RenderPresent(gRenderer);
+        }
+    }
+    for (int i = 0; i < 9; i++) SDL_DestroyTexture(original[i]);
+
+    printf("asteroid textures: %d kB original, %d kB scaled, %d asteroids per frame\n", original_bytes / 1024, mip_bytes / 1024, asteroids_quantity);
+    profilePrint(&asteroid_full);
+    profilePrint(&asteroid_mip);
+}
+
+void benchmarkStarfield()
+{
+    struct profile background_clear = {.name = "background clear"};
+    struct profile background_stars = {.name = "starfield"};
+
+    for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        SDL_SetRenderDrawColor(gRenderer, 96, 128, 255, 255);
+        SDL_RenderClear(gRenderer);
+        SDL_RenderFlush(gRenderer);
+        profileAdd(&background_clear, start);
+
+        start = SDL_GetPerformanceCounter();
+        starfieldRender(&gStarfield, gRenderer, frame * 7);
+        SDL_RenderFlush(gRenderer);
+        profileAdd(&background_stars, start);
+        SDL_RenderPresent(gRenderer);
+    }
+
+    printf("starfield: %d layers, %d kB of textures\n", starfield_layers_quantity, gStarfield.bytes / 1024);
+    profilePrint(&background_clear);
+    profilePrint(&background_stars);
+}
+
+void benchmarkAsteroidStep()
+{
+    int counter = cacheCounterOpen();
+    if (counter < 0) printf("cache misses can't be counted here\n");
+    int fields[] = {asteroids_quantity, 10000, 100000, 1000000};
+    for (int i = 0; i < 4; i++) benchmarkAsteroids(fields[i], counter);
+#ifdef __linux__
+    if (counter >= 0) close(counter);
+#endif
+}
+
+void benchmarkCapture()
+{
+    struct profile capture_draw = {.name = "frame draw"};
+    struct profile capture_readback = {.name = "capture readback"};
+
+    if (!captureStart(CAPTURE_BENCH_PATH, SCREEN_WIDTH, SCREEN_HEIGHT)) return;
+
+    worldInit(&gWorld, 1, 1, 0);
+    particles_count = 0;
+    for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+    {
+        struct world_input input = {false, frame % 200 < 20, frame % 120 < 60, frame % 120 >= 60, true};
+        if (!worldStep(&gWorld, input, &gDraw)) worldInit(&gWorld, 1, frame + 1, gWorld.currentTime);
+        worldTick(&gWorld, gWorld.currentTime + 7);
+        for (int i = 0; i < gWorld.hits_count; i++) createParticles(gWorld.hits[i].x, gWorld.hits[i].y, 12, false);
+        particlesUpdate();
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        SDL_SetRenderDrawColor(gRenderer, 96, 128, 255, 255);
+        SDL_RenderClear(gRenderer);
+        asteroids_render();
+        particles_render();
+        SDL_RenderCopyF(gRenderer, gTexturePlayer, NULL, &gWorld.player);
+        SDL_RenderFlush(gRenderer);
+        profileAdd(&capture_draw, start);
+
+        start = SDL_GetPerformanceCounter();
+        captureFrame(gRenderer, frame * 7);
+        profileAdd(&capture_readback, start);
+        SDL_RenderPresent(gRenderer);
+    }
+    captureStop();
+    remove(CAPTURE_BENCH_PATH);
+
+    struct capture_stats stats = captureStats();
+    printf("video capture: %d frames captured, %d dropped, %d written (%.0f MB)\n", stats.captured, stats.dropped,
+           stats.written, stats.bytes / 1048576.0);
+    profilePrint(&capture_draw);
+    profilePrint(&capture_readback);
+}
+
+void benchmarkSpectator()
+{
+    struct profile spectator_publish = {.name = "spectator publish"};
+    int spectator_asteroids = 0;
+
+    if (!spectatorInit()) return;
+
+    worldInit(&gWorld, 1, 1, 0);
+    for (int frame = 0; frame < BENCHMARK_FRAMES; frame++)
+    {
+        struct world_input input = {false, frame % 200 < 20, frame % 120 < 60, frame % 120 >= 60, true};
+        if (!worldStep(&gWorld, input, &gDraw)) worldInit(&gWorld, 1, frame + 1, gWorld.currentTime);
+        worldTick(&gWorld, gWorld.currentTime + 7);
+        spectator_asteroids += gDraw.asteroids_count;
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        spectatorPublish(&gWorld, &gDraw);
+        profileAdd(&spectator_publish, start);
+    }
+    printf("spectator feed: %d byte slots, %d asteroids per frame on average\n", (int)sizeof(struct spectator_slot),
+           spectator_asteroids / BENCHMARK_FRAMES);
+    profilePrint(&spectator_publish);
+}
+
+void benchmarkLeaderboard()
+{
+    struct profile board_append = {.name = "leaderboard append 1000"};
+    struct profile board_single = {.name = "leaderboard append 1"};
+    struct profile board_open = {.name = "leaderboard open"};
+    struct profile board_place = {.name = "leaderboard place"};
+    struct profile board_top = {.name = "leaderboard top 10"};
+    struct leaderboard board;
+
+    remove(LEADERBOARD_BENCH_PATH);
+    remove(LEADERBOARD_BENCH_INDEX_PATH);
+    if (leaderboardOpen(&board, LEADERBOARD_BENCH_PATH, LEADERBOARD_BENCH_INDEX_PATH))
+    {
+        static struct leaderboard_record runs[1000];
+        worldInit(&gWorld, 1, 1, 0);
+        for (int i = 0; i < LEADERBOARD_BENCH_RUNS + 10000; i++)
+        {
+            struct leaderboard_record* run = &runs[i % 1000];
+            memset(run, 0, sizeof(*run));
+            run->score = worldRand(&gWorld) % 5000;
+            run->duration_ms = worldRand(&gWorld) % 600000;
+            run->source = LEADERBOARD_BATCH;
+            run->seed = i;
+            leaderboardSeal(run);
+
+            //Batches first, then single runs the way the game adds them
+            Uint64 start = SDL_GetPerformanceCounter();
+            if (i >= LEADERBOARD_BENCH_RUNS)
+            {
+                leaderboardAppend(&board, run, 1);
+                profileAdd(&board_single, start);
+            }
+            else if (i % 1000 == 999)
+            {
+                leaderboardAppend(&board, runs, 1000);
+                profileAdd(&board_append, start);
+            }
+        }
+        leaderboardClose(&board);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        bool opened = leaderboardOpen(&board, LEADERBOARD_BENCH_PATH, LEADERBOARD_BENCH_INDEX_PATH);
+        profileAdd(&board_open, start);
+        if (opened)
+        {
+            for (int i = 0; i < 100000; i++)
+            {
+                int32_t score = worldRand(&gWorld) % 5000;
+                start = SDL_GetPerformanceCounter();
+                leaderboardAhead(&board, score, board.records);
+                profileAdd(&board_place, start);
+            }
+            struct leaderboard_entry top[10];
+            for (int i = 0; i < 10000; i++)
+            {
+                start = SDL_GetPerformanceCounter();
+                leaderboardTop(&board, 10, top);
+                profileAdd(&board_top, start);
+            }
+
+            printf("leaderboard: %llu runs, %d MB of runs, %d MB of rank index\n", (unsigned long long)board.records,
+                   (int)(board.records * sizeof(struct leaderboard_record) / 1048576), (int)(board.map_size / 1048576));
+            profilePrint(&board_append);
+            profilePrint(&board_single);
+            profilePrint(&board_open);
+            profilePrint(&board_place);
+            profilePrint(&board_top);
+            leaderboardClose(&board);
+        }
+    }
+    remove(LEADERBOARD_BENCH_PATH);
+    remove(LEADERBOARD_BENCH_INDEX_PATH);
+}
+
+void benchmarkCourse(const char* coursePath)
+{
+    struct course course;
+    if (!courseOpen(&course, coursePath)) return;
+
+    struct profile course_spawn = {.name = "course spawn"};
+    struct profile course_stream = {.name = "course stream"};
+    size_t resident_least = course.size;
+    size_t resident_most = 0;
+    Uint64 spawned = 0;
+
+    worldInit(&gWorld, 1, 1, 0);
+    worldSetCourse(&gWorld, &course);
+    courseStream(&course, 0);
+    int ticks = course.header->duration_ms / 1000 + 1;
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        Uint64 next = gWorld.course_next;
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        worldTick(&gWorld, gWorld.currentTime + 1000);
+        profileAdd(&course_spawn, start);
+        spawned += gWorld.course_next >= next ? gWorld.course_next - next : gWorld.course_next + course.header->asteroids - next;
+
+        start = SDL_GetPerformanceCounter();
+        courseStream(&course, gWorld.clock - gWorld.course_start);
+        profileAdd(&course_stream, start);
+
+        if (tick % 100 == 0)
+        {
+            size_t resident = courseResidentBytes(&course);
+            if (resident < resident_least) resident_least = resident;
+            if (resident > resident_most) resident_most = resident;
+        }
+    }
+
+    printf("course: %llu asteroids spawned in %d s of play, %u chunks of %d kB\n", (unsigned long long)spawned, ticks,
+           course.header->chunks, (int)(COURSE_CHUNK_ASTEROIDS * sizeof(struct course_asteroid) / 1024));
+    printf("course memory: %d to %d kB loaded of %d kB\n", (int)(resident_least / 1024), (int)(resident_most / 1024), (int)(course.size / 1024));
+    profilePrint(&course_spawn);
+    profilePrint(&course_stream);
+    courseClose(&course);
+}
+
+int benchmark(const char* coursePath)
+{
+    //Hidden window with software renderer so results don't depend on the graphics card
+    if (SDL_Init(SDL_INIT_VIDEO) < 0)
+    {
+        printf("SDL could not initialize! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    gWindow = SDL_CreateWindow("Space Raider", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_HIDDEN);
+    if (gWindow != NULL) gRenderer = SDL_CreateRenderer(gWindow, -1, SDL_RENDERER_SOFTWARE);
+    if (gRenderer == NULL)
+    {
+        printf("Renderer could not be created! SDL Error: %s\n", SDL_GetError());
+        return 1;
+    }
+    if (!loadMedia())
+    {
+        printf("Failed to load media!\n");
+        return 1;
+    }
+
+    benchmarkParticles();
+    if (!benchmarkRewind())
+    {
+        closeSDL();
+        return 1;
+    }
+    benchmarkAutopilot();
+    benchmarkAsteroidTextures();
+    benchmarkStarfield();
+    benchmarkAsteroidStep();
+    benchmarkCapture();
+    benchmarkSpectator();
+    benchmarkLeaderboard();
+    if (coursePath != NULL) benchmarkCourse(coursePath);
+
+    closeSDL();
+    return 0;
 }
 /*------------------------------------------MAIN------------------------------------------*/
 
@@ -957,6 +1758,22 @@ int main(int argc, char* argv[])
     //Initialize srand
     srand((unsigned int)time(NULL));
 
+    //Benchmark mode runs without menu and sound
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) return benchmark(argc > 2 ? argv[2] : NULL);
+
+    const char* capturePath = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        //Autopilot mode plays game after game by itself
+        if (strcmp(argv[i], "--autopilot") == 0) attractMode = autopilot = true;
+
+        //Endless mode takes asteroids from a course file instead of creating random ones
+        if (strcmp(argv[i], "--course") == 0 && i + 1 < argc) courseLoaded = courseOpen(&gCourse, argv[++i]);
+
+        //Capture mode records gameplay to a Y4M video
+        if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) capturePath = argv[++i];
+    }
+
     //Start up SDL and create window
     if (!init())
     {
@@ -971,48 +1788,53 @@ int main(int argc, char* argv[])
         }
         else
         {
+            particlesInit();
+            telemetryInit(TELEMETRY_PATH);
+            leaderboardInit(LEADERBOARD_PATH, LEADERBOARD_INDEX_PATH);
+            if (!rewindInit(&gRewind)) printf("Not enough memory for rewinding!\n");
+            autopilotInit(0);
+            spectatorInit();
+            if (capturePath != NULL) capturing = captureStart(capturePath, SCREEN_WIDTH, SCREEN_HEIGHT);
             while(true)
             {
-                 //sets every asteroid as invisible
-                for(int i = 0; i < asteroids_quantity; i++)
-                {
-                    all_asteroids[i].visible = false;
-                    all_asteroids[i].dim.y = SCREEN_HEIGHT;
-                }
-
-                bullets_available = 10;
-                currentScore = 0;
+                //Background world for the menu
+                worldInit(&gWorld, difficulty, rand(), SDL_GetTicks());
+                particles_count = 0;
                 //Event handler
                 SDL_Event e;
 
                 //rendering menu
-                menu_render(e);
-                menuTime = SDL_GetTicks();
-
-
-                //sets every asteroid as invisible
-                for(int i = 0; i < asteroids_quantity; i++)
-                {
-                    all_asteroids[i].visible = false;
-                    all_asteroids[i].dim.y = SCREEN_HEIGHT;
-                }
+                if (!attractMode) menu_render(e);
 
-                for(int i = 0; i < package_quantity; i++)
+                //New game
+                worldInit(&gWorld, difficulty, rand(), SDL_GetTicks());
+                if (courseLoaded)
                 {
-                    all_packages[i].y = SCREEN_HEIGHT;
+                    worldSetCourse(&gWorld, &gCourse);
+                    courseStream(&gCourse, 0);
                 }
+                rewindClear(&gRewind);
+                rewinding = false;
+                autopilotPlayed = false;
 
-                //Player model
-                SDL_FRect player = { SCREEN_WIDTH / 2, SCREEN_HEIGHT - 100, PLAYER_WIDTH, PLAYER_HEIGHT };
+                telemetryBegin(&session, difficulty);
+                lastFrame = SDL_GetPerformanceCounter();
 
                 //While application is running
                 Mix_PlayMusic( game, -1 );
-                while (gameLoop(e, &player))
+                while (gameLoop(e))
                 {
                     // Wait before next frame
                     SDL_Delay(10 - 3*difficulty);
                 }
+
+                session.score = gWorld.currentScore;
+                session.shots_fired = gWorld.shots_fired;
+                session.packages_picked = gWorld.packages_picked;
+                telemetrySubmit(&session);
+                if (quitRequested) break;
             }
+            closeSDL();
         }
     }
 
@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <string.h>
+#include "rewind.h"
+
+//World is compared and stored as 32 bit words
+#define world_words (sizeof(struct world) / sizeof(Uint32))
+
+//Longest possible delta: a run header for every changed word
+#define delta_limit (2 * sizeof(struct world) + sizeof(Uint32))
+
+bool rewindInit(struct rewind* r)
+{
+    memset(r, 0, sizeof(*r));
+
+    //Most steps only change positions and angles, so a delta is usually far smaller than a world
+    r->arena_size = rewind_snapshots_quantity * sizeof(struct world) / 2 + delta_limit;
+    r->arena = malloc(r->arena_size);
+    r->keyframes = malloc(rewind_keyframes_quantity * sizeof(struct world));
+    if (r->arena == NULL || r->keyframes == NULL)
+    {
+        rewindFree(r);
+        return false;
+    }
+
+    //Touch every page now, so the first seconds of play don't pay for page faults
+    memset(r->arena, 0, r->arena_size);
+    memset(r->keyframes, 0, rewind_keyframes_quantity * sizeof(struct world));
+    rewindClear(r);
+    return true;
+}
+
+void rewindClear(struct rewind* r)
+{
+    r->first = 0;
+    r->count = 0;
+    r->keyframe = rewind_keyframes_quantity - 1;
+    r->keyframe_uses = REWIND_KEYFRAME_INTERVAL;
+}
+
+static struct rewind_snapshot* newest(struct rewind* r)
+{
+    return &r->snapshots[(r->first + r->count - 1) % rewind_snapshots_quantity];
+}
+
+static void dropOldest(struct rewind* r)
+{
+    r->first = (r->first + 1) % rewind_snapshots_quantity;
+    r->count--;
+}
+
+//Drops old snapshots until no delta stored in the arena overlaps bytes from start to end.
+//Deltas fill the arena in order, so only the oldest ones can be in the way
+static void freeArena(struct rewind* r, size_t start, size_t end)
+{
+    while (r->count > 0)
+    {
+        int i = 0;
+        struct rewind_snapshot* s = &r->snapshots[r->first];
+        while (s->length == 0 && ++i < r->count) s = &r->snapshots[(r->first + i) % rewind_snapshots_quantity];
+        if (s->length == 0 || s->offset >= end || start >= s->offset + s->length) return;
+
+        //Everything older goes too, the history has no holes
+        for (; i >= 0; i--) dropOldest(r);
+    }
+}
+
+//Writes words that differ from the keyframe as runs of (unchanged count, changed count, changed words)
+static size_t encodeDelta(const Uint32* key, const Uint32* cur, Uint32* out)
+{
+    size_t n = 0;
+    size_t i = 0;
+
+    while (i < world_words)
+    {
+        Uint32 skip = 0;
+        while (i < world_words && cur[i] == key[i] && skip < 0xFFFF)
+        {
+            i++;
+            skip++;
+        }
+
+        //Single unchanged word between changed ones is cheaper to copy than to start a new run
+        size_t start = i;
+        Uint32 count = 0;
+        while (i < world_words && count < 0xFFFF && (cur[i] != key[i] || (i + 1 < world_words && cur[i + 1] != key[i + 1])))
+        {
+            i++;
+            count++;
+        }
+        if (count == 0 && i == world_words) break;
+
+        out[n++] = skip | count << 16;
+        memcpy(&out[n], &cur[start], count * sizeof(Uint32));
+        n += count;
+    }
+    return n * sizeof(Uint32);
+}
+
+static void decodeDelta(const Uint32* in, size_t length, Uint32* world)
+{
+    const Uint32* end = in + length / sizeof(Uint32);
+    size_t i = 0;
+
+    while (in < end)
+    {
+        Uint32 count = *in >> 16;
+        i += *in & 0xFFFF;
+        in++;
+        memcpy(&world[i], in, count * sizeof(Uint32));
+        in += count;
+        i += count;
+    }
+}
+
+void rewindSave(struct rewind* r, const struct world* w)
+{
+    //Only REWIND_SECONDS are kept
+    while (r->count > 0 && w->clock - r->snapshots[r->first].time > REWIND_SECONDS * 1000) dropOldest(r);
+    if (r->count == rewind_snapshots_quantity) dropOldest(r);
+
+    struct rewind_snapshot snapshot = {w->clock, r->keyframe, 0, 0};
+
+    if (r->keyframe_uses < REWIND_KEYFRAME_INTERVAL && r->count > 0)
+    {
+        //Delta goes right after the newest one, or to the start of the arena when there is no room left
+        struct rewind_snapshot* last = newest(r);
+        size_t offset = last->length > 0 ? last->offset + last->length : last->offset;
+        if (offset + delta_limit > r->arena_size) offset = 0;
+        freeArena(r, offset, offset + delta_limit);
+
+        snapshot.offset = offset;
+        snapshot.length = encodeDelta((const Uint32*)&r->keyframes[r->keyframe], (const Uint32*)w, (Uint32*)(r->arena + offset));
+
+        //Delta bigger than half the world isn't worth it
+        if (snapshot.length > sizeof(struct world) / 2) snapshot.length = 0;
+    }
+
+    if (snapshot.length == 0)
+    {
+        //New keyframe, snapshots still using the slot it takes are the oldest ones
+        r->keyframe = (r->keyframe + 1) % rewind_keyframes_quantity;
+        while (r->count > 0 && r->snapshots[r->first].keyframe == r->keyframe) dropOldest(r);
+        r->keyframes[r->keyframe] = *w;
+        r->keyframe_uses = 0;
+        snapshot.keyframe = r->keyframe;
+
+        //Keeps the arena position for the next delta
+        if (r->count > 0)
+        {
+            struct rewind_snapshot* last = newest(r);
+            snapshot.offset = last->length > 0 ? last->offset + last->length : last->offset;
+        }
+    }
+
+    r->keyframe_uses++;
+    r->snapshots[(r->first + r->count) % rewind_snapshots_quantity] = snapshot;
+    r->count++;
+}
+
+bool rewindRestore(struct rewind* r, struct world* w)
+{
+    if (r->count == 0) return false;
+
+    struct rewind_snapshot* s = newest(r);
+    memcpy(w, &r->keyframes[s->keyframe], sizeof(struct world));
+    if (s->length > 0) decodeDelta((const Uint32*)(r->arena + s->offset), s->length, (Uint32*)w);
+    r->count--;
+
+    //Next save starts a new keyframe, so deltas never point at a keyframe newer than themselves
+    r->keyframe_uses = REWIND_KEYFRAME_INTERVAL;
+    return true;
+}
+
+size_t rewindBytes(struct rewind* r)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < r->count; i++)
+    {
+        struct rewind_snapshot* s = &r->snapshots[(r->first + i) % rewind_snapshots_quantity];
+        bytes += s->length > 0 ? s->length : sizeof(struct world);
+    }
+    return bytes + r->count * sizeof(struct rewind_snapshot);
+}
+
+void rewindFree(struct rewind* r)
+{
+    free(r->arena);
+    free(r->keyframes);
+    r->arena = NULL;
+    r->keyframes = NULL;
+    rewindClear(r);
+}
@@ -0,0 +1,65 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "world.h"
+
+//Seconds of play that can be rewound
+#define REWIND_SECONDS 5
+
+//Every this many snapshots one is stored whole, the rest only keep words that differ from it
+#define REWIND_KEYFRAME_INTERVAL 32
+
+//Quantity of snapshots, enough for REWIND_SECONDS at 250 steps per second
+#define rewind_snapshots_quantity (REWIND_SECONDS * 250)
+
+//Quantity of whole worlds, every delta needs its keyframe to still be there
+#define rewind_keyframes_quantity (rewind_snapshots_quantity / REWIND_KEYFRAME_INTERVAL + 2)
+
+//One saved step
+struct rewind_snapshot
+{
+    //Played time of the world, it doesn't jump forward when a rewind is resumed
+    unsigned int time;
+    int keyframe;
+    size_t offset;
+    size_t length;
+};
+
+//History of one world, all memory is allocated once in rewindInit
+struct rewind
+{
+    struct world* keyframes;
+    unsigned char* arena;
+    size_t arena_size;
+    struct rewind_snapshot snapshots[rewind_snapshots_quantity];
+
+    //Oldest snapshot and number of snapshots kept
+    int first;
+    int count;
+
+    //Keyframe used by the newest snapshots and how many snapshots use it
+    int keyframe;
+    int keyframe_uses;
+};
+
+//Allocates the history buffers, returns false when out of memory
+bool rewindInit(struct rewind* r);
+
+//Forgets all snapshots
+void rewindClear(struct rewind* r);
+
+//Saves the world as the newest snapshot, dropping the oldest ones when needed
+void rewindSave(struct rewind* r, const struct world* w);
+
+//Replaces the world with the newest snapshot and removes it, returns false when there is nothing left
+bool rewindRestore(struct rewind* r, struct world* w);
+
+//Bytes taken by the snapshots kept at the moment
+size_t rewindBytes(struct rewind* r);
+
+//Frees the history buffers
+void rewindFree(struct rewind* r);
+
+#endif
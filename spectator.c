@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "spectator.h"
+
+static struct spectator_feed* spectator_feed = NULL;
+
+//Process that publishes the existing feed, 0 when it was left by a game that is gone or can't be read
+static pid_t feedOwner()
+{
+    int file = shm_open(SPECTATOR_NAME, O_RDONLY, 0);
+    if (file < 0) return 0;
+
+    //A game that crashed before it finished creating the feed leaves it shorter
+    struct stat info;
+    void* map = MAP_FAILED;
+    if (fstat(file, &info) == 0 && (size_t)info.st_size >= sizeof(struct spectator_feed))
+    {
+        map = mmap(NULL, sizeof(struct spectator_feed), PROT_READ, MAP_SHARED, file, 0);
+    }
+    close(file);
+    if (map == MAP_FAILED) return 0;
+
+    const struct spectator_feed* feed = map;
+    pid_t owner = 0;
+    if (feed->magic == SPECTATOR_MAGIC && feed->version == SPECTATOR_VERSION)
+    {
+        SDL_MemoryBarrierAcquire();
+        owner = feed->owner;
+    }
+    spectatorClose(feed);
+
+    //Signal 0 only checks that the process is there, EPERM means it is there but belongs to someone else
+    if (owner != 0 && kill(owner, 0) < 0 && errno != EPERM) owner = 0;
+    return owner;
+}
+
+bool spectatorInit()
+{
+    int file = shm_open(SPECTATOR_NAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (file < 0 && errno == EEXIST)
+    {
+        pid_t owner = feedOwner();
+        if (owner != 0)
+        {
+            printf("Spectator feed is already published by the game running as process %d!\n", (int)owner);
+            return false;
+        }
+
+        //Feed was left by a game that crashed
+        shm_unlink(SPECTATOR_NAME);
+        file = shm_open(SPECTATOR_NAME, O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if (file < 0)
+    {
+        printf("Spectator feed could not be created!\n");
+        return false;
+    }
+    if (ftruncate(file, sizeof(struct spectator_feed)) < 0)
+    {
+        printf("Spectator feed could not be created!\n");
+        close(file);
+        shm_unlink(SPECTATOR_NAME);
+        return false;
+    }
+
+    void* map = mmap(NULL, sizeof(struct spectator_feed), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    close(file);
+    if (map == MAP_FAILED)
+    {
+        printf("Spectator feed could not be mapped!\n");
+        shm_unlink(SPECTATOR_NAME);
+        return false;
+    }
+
+    //New object is zeroed, so every slot starts even and nothing is published
+    spectator_feed = map;
+    spectator_feed->slots = spectator_slots_quantity;
+    spectator_feed->frame_size = sizeof(struct spectator_frame);
+    spectator_feed->version = SPECTATOR_VERSION;
+    spectator_feed->owner = getpid();
+    SDL_MemoryBarrierRelease();
+    spectator_feed->magic = SPECTATOR_MAGIC;
+    return true;
+}
+
+void spectatorPublish(const struct world* w, const struct world_draw* draw)
+{
+    if (spectator_feed == NULL) return;
+
+    Uint32 tick = SDL_AtomicGet(&spectator_feed->published);
+    struct spectator_slot* slot = &spectator_feed->slot[tick % spectator_slots_quantity];
+    struct spectator_frame* frame = &slot->frame;
+
+    //Odd sequence tells readers the slot is being written
+    SDL_AtomicIncRef(&slot->sequence);
+
+    frame->tick = tick;
+    frame->published = SDL_GetPerformanceCounter();
+    frame->time = w->currentTime - w->menuTime;
+    frame->score = w->currentScore;
+    frame->player = w->player;
+    memcpy(frame->bullets, w->all_bullets, sizeof(frame->bullets));
+    memcpy(frame->packages, w->all_packages, sizeof(frame->packages));
+    frame->asteroids_count = draw->asteroids_count;
+    memcpy(frame->asteroids, draw->asteroids, draw->asteroids_count * sizeof(struct asteroid_draw));
+
+    SDL_AtomicIncRef(&slot->sequence);
+    SDL_AtomicSet(&spectator_feed->published, tick + 1);
+}
+
+void spectatorQuit()
+{
+    if (spectator_feed == NULL) return;
+    munmap(spectator_feed, sizeof(struct spectator_feed));
+    shm_unlink(SPECTATOR_NAME);
+    spectator_feed = NULL;
+}
+
+const struct spectator_feed* spectatorOpen()
+{
+    int file = shm_open(SPECTATOR_NAME, O_RDONLY, 0);
+    if (file < 0) return NULL;
+
+    //Spectators only read, the game never waits for them
+    void* map = mmap(NULL, sizeof(struct spectator_feed), PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if (map == MAP_FAILED) return NULL;
+
+    const struct spectator_feed* feed = map;
+    if (feed->magic != SPECTATOR_MAGIC || feed->version != SPECTATOR_VERSION || feed->slots != spectator_slots_quantity
+        || feed->frame_size != sizeof(struct spectator_frame))
+    {
+        spectatorClose(feed);
+        return NULL;
+    }
+    return feed;
+}
+
+bool spectatorRead(const struct spectator_feed* feed, Uint64 tick, struct spectator_frame* frame)
+{
+    struct spectator_slot* slot = (struct spectator_slot*)&feed->slot[tick % spectator_slots_quantity];
+
+    int before = SDL_AtomicGet(&slot->sequence);
+    if (before & 1) return false;
+    SDL_MemoryBarrierAcquire();
+
+    //Count is checked before it is used, a torn frame can have any value in it
+    memcpy(frame, &slot->frame, offsetof(struct spectator_frame, asteroids));
+    if (frame->asteroids_count < 0 || frame->asteroids_count > asteroids_quantity) frame->asteroids_count = 0;
+    memcpy(frame->asteroids, slot->frame.asteroids, frame->asteroids_count * sizeof(struct asteroid_draw));
+
+    SDL_MemoryBarrierAcquire();
+    return SDL_AtomicGet(&slot->sequence) == before && frame->tick == tick;
+}
+
+void spectatorClose(const struct spectator_feed* feed)
+{
+    munmap((void*)feed, sizeof(struct spectator_feed));
+}
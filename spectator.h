@@ -0,0 +1,78 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "world.h"
+
+//Shared memory object the game publishes to
+#define SPECTATOR_NAME "/spaceraider-feed"
+
+//Marks a feed ("SRF1")
+#define SPECTATOR_MAGIC 0x31465253u
+#define SPECTATOR_VERSION 2
+
+//Frames kept in the feed, a spectator that falls further behind skips frames
+#define spectator_slots_quantity 8
+
+//World as it was shown in one tick
+struct spectator_frame
+{
+    //Number of the frame since the game was started, and performance counter when it was published
+    Uint64 tick;
+    Uint64 published;
+
+    //Ms since the current run started
+    Uint32 time;
+    int score;
+    SDL_FRect player;
+    SDL_Rect bullets[bullets_quantity];
+    SDL_Rect packages[package_quantity];
+
+    //Only the first asteroids_count asteroids are written
+    int asteroids_count;
+    struct asteroid_draw asteroids[asteroids_quantity];
+};
+
+//One frame guarded by its own sequence number, which is odd while the game writes the frame
+struct spectator_slot
+{
+    SDL_atomic_t sequence;
+    struct spectator_frame frame;
+};
+
+//Everything in the shared memory object
+struct spectator_feed
+{
+    Uint32 magic;
+    Uint16 version;
+    Uint16 slots;
+    Uint32 frame_size;
+
+    //Process of the game that publishes the feed, another game only replaces the feed once it is gone
+    Uint32 owner;
+
+    //Frames published so far, frame n is in slot n % spectator_slots_quantity
+    SDL_atomic_t published;
+    struct spectator_slot slot[spectator_slots_quantity];
+};
+
+//Creates the feed, returns false when shared memory can't be used or another running game publishes one
+bool spectatorInit();
+
+//Writes the world straight into the next slot, never waits for spectators
+void spectatorPublish(const struct world* w, const struct world_draw* draw);
+
+//Removes the feed
+void spectatorQuit();
+
+//Maps the feed of a running game for reading, returns NULL when there is none
+const struct spectator_feed* spectatorOpen();
+
+//Copies frame number tick, returns false when it was already overwritten or was being written
+bool spectatorRead(const struct spectator_feed* feed, Uint64 tick, struct spectator_frame* frame);
+
+//Unmaps the feed
+void spectatorClose(const struct spectator_feed* feed);
+
+#endif
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <string.h>
+#include "starfield.h"
+#include "world.h"
+
+//Color of space behind the farthest stars
+#define STARFIELD_SPACE 0xFF080A20u
+
+//Stars in one tile of a layer, their biggest size in px, brightness of the dimmest of them and px per second
+static const struct
+{
+    int stars;
+    int size;
+    int brightness;
+    int speed;
+} STARFIELD_LAYERS[starfield_layers_quantity] = {
+    {220, 1, 70, 6},
+    {90, 2, 130, 18},
+    {30, 3, 190, 45},
+};
+
+//Stars are placed on one tile that wraps at its top and bottom, then the tile is repeated down the texture
+static SDL_Texture* createLayer(SDL_Renderer* renderer, int layer, unsigned int* seed, int width, int height)
+{
+    int rows = height + STARFIELD_TILE;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, rows, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (surface == NULL) return NULL;
+
+    //Farthest layer is opaque, so drawing it replaces clearing the screen
+    Uint32 empty = layer == 0 ? STARFIELD_SPACE : 0;
+    for (int y = 0; y < STARFIELD_TILE; y++)
+    {
+        Uint32* row = (Uint32*)((Uint8*)surface->pixels + y * surface->pitch);
+        for (int x = 0; x < width; x++) row[x] = empty;
+    }
+
+    for (int i = 0; i < STARFIELD_LAYERS[layer].stars; i++)
+    {
+        int size = xorshiftRand(seed) % STARFIELD_LAYERS[layer].size + 1;
+        int x = xorshiftRand(seed) % (width - size + 1);
+        int y = xorshiftRand(seed) % STARFIELD_TILE;
+        int dimmest = STARFIELD_LAYERS[layer].brightness;
+        Uint32 r = dimmest + xorshiftRand(seed) % (256 - dimmest), g = r, b = r;
+
+        //Some stars are a little blue or yellow
+        int tint = xorshiftRand(seed) % 4;
+        if (tint == 1) r = r * 3 / 4;
+        else if (tint == 2) b = b * 3 / 4;
+        Uint32 color = 0xFF000000u | r << 16 | g << 8 | b;
+
+        for (int dy = 0; dy < size; dy++)
+        {
+            Uint32* row = (Uint32*)((Uint8*)surface->pixels + (y + dy) % STARFIELD_TILE * surface->pitch);
+            for (int dx = 0; dx < size; dx++) row[x + dx] = color;
+        }
+    }
+
+    //Any height rows starting in the first tile show the stars without a seam
+    for (int y = STARFIELD_TILE; y < rows; y++)
+    {
+        memcpy((Uint8*)surface->pixels + y * surface->pitch, (Uint8*)surface->pixels + y % STARFIELD_TILE * surface->pitch,
+               width * sizeof(Uint32));
+    }
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_FreeSurface(surface);
+    if (texture != NULL) SDL_SetTextureBlendMode(texture, layer == 0 ? SDL_BLENDMODE_NONE : SDL_BLENDMODE_BLEND);
+    return texture;
+}
+
+bool starfieldInit(struct starfield* sf, SDL_Renderer* renderer, unsigned int seed, int width, int height)
+{
+    memset(sf, 0, sizeof(*sf));
+    sf->width = width;
+    sf->height = height;
+
+    for (int i = 0; i < starfield_layers_quantity; i++)
+    {
+        sf->layers[i].texture = createLayer(renderer, i, &seed, width, height);
+        sf->layers[i].speed = STARFIELD_LAYERS[i].speed;
+        if (sf->layers[i].texture == NULL)
+        {
+            printf("Starfield could not be created! SDL Error: %s\n", SDL_GetError());
+            starfieldFree(sf);
+            return false;
+        }
+        sf->bytes += width * (height + STARFIELD_TILE) * sizeof(Uint32);
+    }
+    return true;
+}
+
+bool starfieldRender(struct starfield* sf, SDL_Renderer* renderer, unsigned int time)
+{
+    if (sf->layers[0].texture == NULL) return false;
+
+    SDL_Rect screen = {0, 0, sf->width, sf->height};
+    for (int i = 0; i < starfield_layers_quantity; i++)
+    {
+        //Stars move down, so the window into the texture moves up from the second tile
+        int offset = (Uint64)time * sf->layers[i].speed / 1000 % STARFIELD_TILE;
+        SDL_Rect source = {0, STARFIELD_TILE - offset, sf->width, sf->height};
+        SDL_RenderCopy(renderer, sf->layers[i].texture, &source, &screen);
+    }
+    return true;
+}
+
+void starfieldFree(struct starfield* sf)
+{
+    for (int i = 0; i < starfield_layers_quantity; i++)
+    {
+        if (sf->layers[i].texture != NULL) SDL_DestroyTexture(sf->layers[i].texture);
+        sf->layers[i].texture = NULL;
+    }
+    sf->bytes = 0;
+}
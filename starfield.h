@@ -0,0 +1,40 @@
+#ifndef STARFIELD_H
+#define STARFIELD_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+//Layers from the farthest, which also covers the screen with the color of space, to the nearest
+#define starfield_layers_quantity 3
+
+//Stars of a layer repeat every STARFIELD_TILE rows, the texture holds a screen and one more tile of them
+#define STARFIELD_TILE 256
+
+//Stars drawn in advance into one texture that scrolls down at its own speed
+struct starfield_layer
+{
+    SDL_Texture* texture;
+    int speed;
+};
+
+struct starfield
+{
+    struct starfield_layer layers[starfield_layers_quantity];
+    int width;
+    int height;
+
+    //Memory of all layer textures
+    int bytes;
+};
+
+//Generates the stars of every layer from seed and renders them into textures, returns false when one can't be created
+bool starfieldInit(struct starfield* sf, SDL_Renderer* renderer, unsigned int seed, int width, int height);
+
+//Draws all layers, scrolled to where they are time ms after the start; one copy per layer, nothing per star.
+//Returns false when there is no starfield, the screen is left as it was then
+bool starfieldRender(struct starfield* sf, SDL_Renderer* renderer, unsigned int time);
+
+//Destroys the textures
+void starfieldFree(struct starfield* sf);
+
+#endif
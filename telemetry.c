@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <SDL2/SDL.h>
+#include "telemetry.h"
+#include "writer.h"
+
+//Quantity of records waiting for the writer, has to be a power of two
+#define telemetry_ring_quantity 64
+
+static struct telemetry_record telemetry_ring[telemetry_ring_quantity];
+static struct writer telemetry_writer;
+static int telemetry_file = -1;
+
+//Everything taken from the ring in one pass goes to the disk in a single write
+static struct telemetry_record telemetry_batch[telemetry_ring_quantity];
+static int telemetry_batch_count = 0;
+
+static void takeRecord(void* data, void* item)
+{
+    (void)data;
+    telemetry_batch[telemetry_batch_count++] = *(struct telemetry_record*)item;
+}
+
+static void writeBatch(void* data)
+{
+    (void)data;
+    if (!writeAll(telemetry_file, telemetry_batch, telemetry_batch_count * sizeof(struct telemetry_record)))
+    {
+        printf("Failed to write telemetry: %s\n", strerror(errno));
+    }
+    telemetry_batch_count = 0;
+}
+
+bool telemetryInit(const char* path)
+{
+    telemetry_file = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (telemetry_file < 0)
+    {
+        printf("Unable to open telemetry log %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    if (!writerStart(&telemetry_writer, "telemetry", telemetry_ring, sizeof(struct telemetry_record),
+                     telemetry_ring_quantity, takeRecord, writeBatch, NULL))
+    {
+        printf("Telemetry writer could not be started! SDL Error: %s\n", SDL_GetError());
+        telemetryQuit();
+        return false;
+    }
+    return true;
+}
+
+void telemetryBegin(struct telemetry_record* record, int difficulty)
+{
+    memset(record, 0, sizeof(*record));
+    record->magic = TELEMETRY_MAGIC;
+    record->version = TELEMETRY_VERSION;
+    record->size = sizeof(*record);
+    record->start_time = time(NULL);
+    record->difficulty = difficulty;
+}
+
+void telemetryAddFrame(struct telemetry_record* record, double frame_ms)
+{
+    int bucket = frame_ms / TELEMETRY_BUCKET_MS;
+
+    if (bucket >= TELEMETRY_HISTOGRAM_BUCKETS) bucket = TELEMETRY_HISTOGRAM_BUCKETS - 1;
+    record->frame_histogram[bucket]++;
+    record->frames++;
+}
+
+bool telemetrySubmit(const struct telemetry_record* record)
+{
+    return writerSubmit(&telemetry_writer, record);
+}
+
+void telemetryQuit()
+{
+    writerStop(&telemetry_writer);
+    if (SDL_AtomicGet(&telemetry_writer.dropped) > 0)
+    {
+        printf("Telemetry: %d records dropped\n", SDL_AtomicGet(&telemetry_writer.dropped));
+    }
+    if (telemetry_file >= 0)
+    {
+        close(telemetry_file);
+        telemetry_file = -1;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Marks the beginning of every record in the log ("SRT1")
+#define TELEMETRY_MAGIC 0x31545253u
+#define TELEMETRY_VERSION 1
+
+//Frame times are counted in 2 ms wide buckets, the last one takes everything slower
+#define TELEMETRY_HISTOGRAM_BUCKETS 16
+#define TELEMETRY_BUCKET_MS 2
+
+//Default log file, records are only ever appended to it
+#define TELEMETRY_PATH "telemetry.bin"
+
+//One finished run, written to the log exactly as it is in memory (little endian, no implicit padding)
+struct telemetry_record
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    int64_t start_time;
+    uint32_t duration_ms;
+    int32_t score;
+    uint32_t difficulty;
+    uint32_t shots_fired;
+    uint32_t packages_picked;
+    uint32_t peak_asteroids;
+    uint32_t frames;
+    uint32_t reserved;
+    uint32_t frame_histogram[TELEMETRY_HISTOGRAM_BUCKETS];
+};
+
+//Opens the log and starts the writer thread
+bool telemetryInit(const char* path);
+
+//Clears the record and stamps it with the current time
+void telemetryBegin(struct telemetry_record* record, int difficulty);
+
+//Counts one frame in the frame time histogram
+void telemetryAddFrame(struct telemetry_record* record, double frame_ms);
+
+//Queues the record for writing, never blocks; returns false if the queue was full and the record was dropped
+bool telemetrySubmit(const struct telemetry_record* record);
+
+//Writes everything still queued, stops the writer thread and closes the log
+void telemetryQuit();
+
+#endif
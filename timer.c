@@ -0,0 +1,98 @@
+#include "timer.h"
+
+void timerInit(struct timer_wheel* wheel, unsigned int now)
+{
+    wheel->now = now;
+    for (int level = 0; level < timer_levels_quantity; level++)
+    {
+        for (int slot = 0; slot < timer_slots_quantity; slot++) wheel->slots[level][slot] = -1;
+    }
+
+    //All timers are in the free list
+    for (int i = 0; i < timers_quantity; i++) wheel->timers[i].next = i + 1;
+    wheel->timers[timers_quantity - 1].next = -1;
+    wheel->free = 0;
+}
+
+//Puts the timer into the slot of the lowest level that reaches its time
+static void place(struct timer_wheel* wheel, int i)
+{
+    struct timer* timer = &wheel->timers[i];
+    unsigned int delta = timer->expires - wheel->now;
+
+    //Timer that is already due goes to the slot of the next tick
+    if ((int)delta < 0)
+    {
+        timer->expires = wheel->now;
+        delta = 0;
+    }
+
+    int level = 0;
+    while (level < timer_levels_quantity - 1 && delta >= 1u << (TIMER_SLOT_BITS * (level + 1))) level++;
+
+    //Too far for the last level: it waits there and is placed again when its slot comes
+    unsigned int expires = timer->expires;
+    if (level == timer_levels_quantity - 1 && delta >= 1u << (TIMER_SLOT_BITS * timer_levels_quantity))
+    {
+        expires = wheel->now + (1u << (TIMER_SLOT_BITS * timer_levels_quantity)) - 1;
+    }
+
+    int slot = (expires >> (TIMER_SLOT_BITS * level)) & (timer_slots_quantity - 1);
+    timer->next = wheel->slots[level][slot];
+    wheel->slots[level][slot] = i;
+}
+
+bool timerAdd(struct timer_wheel* wheel, unsigned int expires, int event)
+{
+    int i = wheel->free;
+    if (i < 0) return false;
+    wheel->free = wheel->timers[i].next;
+
+    wheel->timers[i].expires = expires;
+    wheel->timers[i].event = event;
+    place(wheel, i);
+    return true;
+}
+
+//Moves timers of one slot of a higher level down, now that the time they are in has come
+static void cascade(struct timer_wheel* wheel, int level)
+{
+    int slot = (wheel->now >> (TIMER_SLOT_BITS * level)) & (timer_slots_quantity - 1);
+    int i = wheel->slots[level][slot];
+    wheel->slots[level][slot] = -1;
+
+    while (i >= 0)
+    {
+        int next = wheel->timers[i].next;
+        place(wheel, i);
+        i = next;
+    }
+}
+
+void timerAdvance(struct timer_wheel* wheel, unsigned int time, timer_handler handler, void* data)
+{
+    while ((int)(time - wheel->now) >= 0)
+    {
+        //When a level goes around, the next slot of the level above is spread over it
+        for (int level = 1; level < timer_levels_quantity; level++)
+        {
+            if ((wheel->now & ((1u << (TIMER_SLOT_BITS * level)) - 1)) != 0) break;
+            cascade(wheel, level);
+        }
+
+        //Slot is emptied first, so handlers can add timers to it again
+        int slot = wheel->now & (timer_slots_quantity - 1);
+        int i = wheel->slots[0][slot];
+        wheel->slots[0][slot] = -1;
+        unsigned int now = wheel->now++;
+
+        while (i >= 0)
+        {
+            struct timer expired = wheel->timers[i];
+            wheel->timers[i].next = wheel->free;
+            wheel->free = i;
+            handler(data, expired.event, now);
+            i = expired.next;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdbool.h>
+
+//Every level of the wheel has 64 slots, a slot of one level covers the whole level below it
+#define TIMER_SLOT_BITS 6
+#define timer_slots_quantity (1 << TIMER_SLOT_BITS)
+
+//4 levels of 1 ms ticks reach 2^24 ms (4.6 hours) ahead, later timers wait in the last level
+#define timer_levels_quantity 4
+
+//Timers that can be waiting at once
+#define timers_quantity 32
+
+//One waiting timer, timers in the same slot are linked by index
+struct timer
+{
+    unsigned int expires;
+    int event;
+    int next;
+};
+
+//Hierarchical timer wheel. It has no pointers, so it can be copied together with the world that owns it
+struct timer_wheel
+{
+    //Next tick that will be handled
+    unsigned int now;
+    int slots[timer_levels_quantity][timer_slots_quantity];
+    struct timer timers[timers_quantity];
+    int free;
+};
+
+//Called for every expired timer with the time it expired at
+typedef void (*timer_handler)(void* data, int event, unsigned int time);
+
+//Empties the wheel, first tick handled is now
+void timerInit(struct timer_wheel* wheel, unsigned int now);
+
+//Starts a timer in O(1), timers already due expire on the next tick; returns false when all timers are taken
+bool timerAdd(struct timer_wheel* wheel, unsigned int expires, int event);
+
+//Handles ticks up to time, calling handler for every timer that expires. Handlers may add timers
+void timerAdvance(struct timer_wheel* wheel, unsigned int time, timer_handler handler, void* data);
+
+#endif
@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <SDL2/SDL.h>
+#include "../world.h"
+#include "../leaderboard.h"
+
+//Plays many seeded games without a window on all cores and prints survival time and score distributions
+//Usage: batch [-n games per difficulty] [-p random|dodge] [-s seed] [-t threads]
+//             [--spawn-base ms] [--spawn-step ms] [--max-seconds s] [--course file] [--csv] [--leaderboard]
+//--leaderboard adds every game to the leaderboard of the game
+
+#define difficulty_levels 3
+
+//One simulated game
+struct batch_game
+{
+    int difficulty;
+    unsigned int seed;
+    unsigned int survival_ms;
+    int score;
+    bool capped;
+};
+
+//Settings shared by all workers
+struct batch
+{
+    struct batch_game* games;
+    int games_count;
+    SDL_atomic_t next_game;
+    bool dodge;
+    int spawn_base;
+    int spawn_step;
+    unsigned int max_ms;
+    //Course every game plays instead of random asteroids, NULL when there is none
+    struct course* course;
+};
+
+//Random policy: holds a random direction for a while and shoots now and then
+static struct world_input randomInput(unsigned int* state, int* hold, struct world_input held)
+{
+    if (*hold > 0)
+    {
+        (*hold)--;
+        held.fire = xorshiftRand(state) % 20 == 0;
+        return held;
+    }
+
+    struct world_input input = {false, false, false, false, false};
+    int direction = xorshiftRand(state) % 9;
+    input.up = direction / 3 == 0;
+    input.down = direction / 3 == 2;
+    input.left = direction % 3 == 0;
+    input.right = direction % 3 == 2;
+    *hold = xorshiftRand(state) % 50 + 10;
+    return input;
+}
+
+//Scripted policy: keeps low, slides away from the closest asteroid above and shoots it
+static struct world_input dodgeInput(struct world* w)
+{
+    struct world_input input = {false, true, false, false, false};
+    SDL_FRect* player = &w->player;
+    float center = player->x + PLAYER_WIDTH / 2;
+    float closest = SCREEN_HEIGHT;
+    float threat = -1;
+
+    for (int i = 0; i < asteroids_quantity; i++)
+    {
+        SDL_FRect* dim = &w->all_asteroids[i].dim;
+        float gap = player->y - (dim->y + dim->h);
+        if (dim->w == 0 || gap < -PLAYER_HEIGHT || gap > 250) continue;
+        if (dim->x + dim->w < player->x - 20 || dim->x > player->x + PLAYER_WIDTH + 20) continue;
+        if (gap < closest)
+        {
+            closest = gap;
+            threat = dim->x + dim->w / 2;
+        }
+    }
+
+    if (threat >= 0)
+    {
+        bool room_left = player->x > PLAYER_WIDTH;
+        bool room_right = player->x + 2 * PLAYER_WIDTH < SCREEN_WIDTH;
+        if ((threat > center && room_left) || !room_right) input.left = true;
+        else input.right = true;
+        input.fire = true;
+    }
+    return input;
+}
+
+static void playGame(struct batch* batch, struct batch_game* game)
+{
+    //Same frame length as the delay in the game loop
+    unsigned int frame_ms = 10 - 3 * game->difficulty;
+    struct world w;
+    struct world_input held = {false, false, false, false, false};
+    int hold = 0;
+    //Policy has its own generator so it doesn't change which asteroids the world creates
+    unsigned int policy_seed = game->seed * 2654435761u | 1;
+
+    worldInit(&w, game->difficulty, game->seed, 0);
+    w.spawn_base = batch->spawn_base;
+    w.spawn_step = batch->spawn_step;
+    if (batch->course != NULL) worldSetCourse(&w, batch->course);
+
+    while (true)
+    {
+        struct world_input input;
+        if (batch->dodge) input = dodgeInput(&w);
+        else input = held = randomInput(&policy_seed, &hold, held);
+
+        if (!worldStep(&w, input, NULL)) break;
+        worldTick(&w, w.currentTime + frame_ms);
+        if (w.currentTime - w.menuTime >= batch->max_ms)
+        {
+            game->capped = true;
+            break;
+        }
+    }
+
+    game->survival_ms = w.currentTime - w.menuTime;
+    game->score = w.currentScore;
+}
+
+static int batchWorker(void* data)
+{
+    struct batch* batch = data;
+    int i;
+    while ((i = SDL_AtomicAdd(&batch->next_game, 1)) < batch->games_count)
+    {
+        playGame(batch, &batch->games[i]);
+    }
+    return 0;
+}
+
+static int compareInt(const void* a, const void* b)
+{
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+//Prints mean and percentiles of the values
+static void printDistribution(const char* name, int* values, int count, double scale)
+{
+    double sum = 0;
+    for (int i = 0; i < count; i++) sum += values[i];
+    qsort(values, count, sizeof(int), compareInt);
+
+    printf("  %-10s mean %9.2f   p10 %9.2f   p50 %9.2f   p90 %9.2f   p99 %9.2f   max %9.2f\n", name,
+           sum / count * scale, values[count / 10] * scale, values[count / 2] * scale,
+           values[count * 9 / 10] * scale, values[count * 99 / 100] * scale, values[count - 1] * scale);
+}
+
+int main(int argc, char* argv[])
+{
+    int games_per_level = 1000;
+    unsigned int seed = 1;
+    int threads = SDL_GetCPUCount();
+    bool csv = false;
+    bool board = false;
+    struct batch batch = {0};
+    batch.spawn_base = 300;
+    batch.spawn_step = 50;
+    batch.max_ms = 600 * 1000;
+    struct course course;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "-n") == 0 && has_value) games_per_level = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-p") == 0 && has_value) batch.dodge = strcmp(argv[++i], "dodge") == 0;
+        else if (strcmp(argv[i], "-s") == 0 && has_value) seed = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-t") == 0 && has_value) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--spawn-base") == 0 && has_value) batch.spawn_base = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--spawn-step") == 0 && has_value) batch.spawn_step = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-seconds") == 0 && has_value) batch.max_ms = atoi(argv[++i]) * 1000u;
+        else if (strcmp(argv[i], "--course") == 0 && has_value)
+        {
+            if (!courseOpen(&course, argv[++i])) return 1;
+            batch.course = &course;
+        }
+        else if (strcmp(argv[i], "--csv") == 0) csv = true;
+        else if (strcmp(argv[i], "--leaderboard") == 0) board = true;
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (games_per_level < 1 || threads < 1)
+    {
+        fprintf(stderr, "Need at least one game and one thread\n");
+        return 1;
+    }
+
+    //Game i always gets the same seed, so results don't depend on the thread count
+    batch.games_count = games_per_level * difficulty_levels;
+    batch.games = calloc(batch.games_count, sizeof(struct batch_game));
+    if (batch.games == NULL)
+    {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < batch.games_count; i++)
+    {
+        batch.games[i].difficulty = i / games_per_level;
+        batch.games[i].seed = seed + i;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    SDL_Thread** workers = calloc(threads, sizeof(SDL_Thread*));
+    for (int i = 0; i < threads; i++) workers[i] = SDL_CreateThread(batchWorker, "batch", &batch);
+    for (int i = 0; i < threads; i++)
+    {
+        if (workers[i] != NULL) SDL_WaitThread(workers[i], NULL);
+        else batchWorker(&batch);
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    if (csv)
+    {
+        printf("difficulty,seed,survival_ms,score,capped\n");
+        for (int i = 0; i < batch.games_count; i++)
+        {
+            struct batch_game* game = &batch.games[i];
+            printf("%d,%u,%u,%d,%d\n", game->difficulty, game->seed, game->survival_ms, game->score, game->capped);
+        }
+    }
+    else
+    {
+        printf("%d games (%s policy, spawn %d - %d * difficulty ms) on %d threads in %.2f s\n", batch.games_count,
+               batch.dodge ? "dodge" : "random", batch.spawn_base, batch.spawn_step, threads, seconds);
+        if (batch.course != NULL) printf("asteroids from a course of %llu asteroids, %u s per lap\n",
+                                        (unsigned long long)course.header->asteroids, course.header->duration_ms / 1000);
+
+        int* survival = malloc(games_per_level * sizeof(int));
+        int* score = malloc(games_per_level * sizeof(int));
+        for (int level = 0; level < difficulty_levels; level++)
+        {
+            int capped = 0;
+            for (int i = 0; i < games_per_level; i++)
+            {
+                struct batch_game* game = &batch.games[level * games_per_level + i];
+                survival[i] = game->survival_ms;
+                score[i] = game->score;
+                capped += game->capped;
+            }
+            printf("difficulty %d (%d games reached the time limit)\n", level + 1, capped);
+            printDistribution("survival s", survival, games_per_level, 0.001);
+            printDistribution("score", score, games_per_level, 1);
+        }
+        free(survival);
+        free(score);
+    }
+
+    //Games go to the leaderboard in big batches, each batch is one write
+    struct leaderboard leaderboard;
+    if (board && leaderboardOpen(&leaderboard, LEADERBOARD_PATH, LEADERBOARD_INDEX_PATH))
+    {
+        static struct leaderboard_record runs[1000];
+        int count = 0;
+        for (int i = 0; i < batch.games_count; i++)
+        {
+            struct batch_game* game = &batch.games[i];
+            struct leaderboard_record* run = &runs[count++];
+            memset(run, 0, sizeof(*run));
+            run->score = game->score;
+            run->duration_ms = game->survival_ms;
+            run->difficulty = game->difficulty;
+            run->source = LEADERBOARD_BATCH;
+            run->time = time(NULL);
+            run->seed = game->seed;
+            leaderboardSeal(run);
+            if (count == 1000 || i == batch.games_count - 1)
+            {
+                if (!leaderboardAppend(&leaderboard, runs, count)) break;
+                count = 0;
+            }
+        }
+        if (!csv) printf("leaderboard has %llu runs now\n", (unsigned long long)leaderboard.records);
+        leaderboardClose(&leaderboard);
+    }
+
+    free(workers);
+    free(batch.games);
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "../course.h"
+#include "../world.h"
+
+//Writes a course file for the endless mode, either random or from an authored CSV
+//Usage: course_gen -o course.bin [-n asteroids] [-s seed] [-i mean interval ms]
+//       course_gen -o course.bin --csv course.csv [-d lap ms]
+//CSV lines are time_ms,x,y,size,speed,texture[,angle,rotation] with speed in thousandths of a pixel per step
+//and rotation in hundredths of a degree per step; lines that don't start with a digit are skipped
+
+//Same ranges as createAsteoid, but always fully on the screen
+static struct course_asteroid randomAsteroid(unsigned int* state, uint32_t time)
+{
+    struct course_asteroid a = {0};
+    a.time = time;
+    a.size = xorshiftRand(state) % 70 + 30;
+    a.x = xorshiftRand(state) % (SCREEN_WIDTH - a.size);
+    a.y = -(int)(xorshiftRand(state) % 100) - 100;
+    a.speed = xorshiftRand(state) % 501 + 900;
+    a.texture = xorshiftRand(state) % 9;
+    a.angle = xorshiftRand(state) % 360 + 1;
+    a.rotation = xorshiftRand(state) % 40 + 1;
+    return a;
+}
+
+static int compareTime(const void* a, const void* b)
+{
+    uint32_t x = ((const struct course_asteroid*)a)->time, y = ((const struct course_asteroid*)b)->time;
+    return (x > y) - (x < y);
+}
+
+//Reads an authored course, returns NULL when the file can't be read
+static struct course_asteroid* readCsv(const char* path, uint64_t* count)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Unable to open %s\n", path);
+        return NULL;
+    }
+
+    uint64_t capacity = 1024;
+    struct course_asteroid* asteroids = malloc(capacity * sizeof(struct course_asteroid));
+    char line[256];
+    *count = 0;
+    while (asteroids != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        if (line[0] < '0' || line[0] > '9') continue;
+
+        unsigned int time, size, speed, texture, angle = 0, rotation = 0;
+        int x, y;
+        if (sscanf(line, "%u,%d,%d,%u,%u,%u,%u,%u", &time, &x, &y, &size, &speed, &texture, &angle, &rotation) < 6)
+        {
+            fprintf(stderr, "Skipping line: %s", line);
+            continue;
+        }
+        if (*count == capacity)
+        {
+            capacity *= 2;
+            struct course_asteroid* bigger = realloc(asteroids, capacity * sizeof(struct course_asteroid));
+            if (bigger == NULL) free(asteroids);
+            asteroids = bigger;
+            if (asteroids == NULL) break;
+        }
+
+        struct course_asteroid a = {time, x, y, speed, angle, size, texture, rotation, 0};
+        asteroids[(*count)++] = a;
+    }
+    fclose(file);
+    if (asteroids == NULL) fprintf(stderr, "Out of memory\n");
+    return asteroids;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* output = NULL;
+    const char* csv = NULL;
+    uint64_t count = 1000000;
+    unsigned int seed = 1;
+    unsigned int interval = 200;
+    unsigned int duration = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "-o") == 0 && has_value) output = argv[++i];
+        else if (strcmp(argv[i], "-n") == 0 && has_value) count = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-s") == 0 && has_value) seed = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-i") == 0 && has_value) interval = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-d") == 0 && has_value) duration = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--csv") == 0 && has_value) csv = argv[++i];
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (output == NULL || interval == 0)
+    {
+        fprintf(stderr, "Usage: course_gen -o course.bin [-n asteroids] [-s seed] [-i interval ms] [--csv course.csv] [-d lap ms]\n");
+        return 1;
+    }
+
+    //Authored courses are sorted here, random ones are created in order
+    struct course_asteroid* authored = NULL;
+    if (csv != NULL)
+    {
+        authored = readCsv(csv, &count);
+        if (authored == NULL) return 1;
+        qsort(authored, count, sizeof(struct course_asteroid), compareTime);
+    }
+    if (count == 0)
+    {
+        fprintf(stderr, "Course has no asteroids\n");
+        return 1;
+    }
+
+    struct course_header header = {0};
+    header.magic = COURSE_MAGIC;
+    header.version = COURSE_VERSION;
+    header.record_size = sizeof(struct course_asteroid);
+    header.chunk_asteroids = COURSE_CHUNK_ASTEROIDS;
+    header.chunks = (count + COURSE_CHUNK_ASTEROIDS - 1) / COURSE_CHUNK_ASTEROIDS;
+    header.asteroids = count;
+    header.data_offset = (sizeof(header) + header.chunks * sizeof(uint32_t) + COURSE_DATA_ALIGN - 1) / COURSE_DATA_ALIGN * COURSE_DATA_ALIGN;
+
+    uint32_t* chunk_times = calloc(header.chunks, sizeof(uint32_t));
+    FILE* file = fopen(output, "wb");
+    if (chunk_times == NULL || file == NULL)
+    {
+        fprintf(stderr, "Unable to create %s\n", output);
+        return 1;
+    }
+
+    //Asteroids go first, the header and the chunk index are written when all chunk times are known
+    fseek(file, header.data_offset, SEEK_SET);
+    uint64_t time = 0;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        struct course_asteroid a;
+        if (authored != NULL) a = authored[i];
+        else
+        {
+            time += interval / 2 + xorshiftRand(&seed) % interval;
+            if (time > UINT32_MAX)
+            {
+                fprintf(stderr, "Course is longer than %u ms, stopping\n", UINT32_MAX);
+                return 1;
+            }
+            a = randomAsteroid(&seed, time);
+        }
+
+        if (i % COURSE_CHUNK_ASTEROIDS == 0) chunk_times[i / COURSE_CHUNK_ASTEROIDS] = a.time;
+        if (fwrite(&a, sizeof(a), 1, file) != 1)
+        {
+            fprintf(stderr, "Unable to write %s\n", output);
+            return 1;
+        }
+        time = a.time;
+    }
+    header.duration_ms = duration > time ? duration : time + (authored != NULL ? 1000 : interval);
+
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(chunk_times, sizeof(uint32_t), header.chunks, file);
+
+    //Written pages are flushed, so the game can drop them from memory once they are behind
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0 || fclose(file) != 0)
+    {
+        fprintf(stderr, "Unable to write %s\n", output);
+        return 1;
+    }
+
+    printf("%s: %llu asteroids in %u chunks, %.1f MB, %u s per lap\n", output, (unsigned long long)count, header.chunks,
+           (header.data_offset + count * sizeof(struct course_asteroid)) / 1048576.0, header.duration_ms / 1000);
+    free(authored);
+    free(chunk_times);
+    return 0;
+}
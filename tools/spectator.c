@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "../spectator.h"
+
+//Follows the spectator feed of a running game without a window and reports what it received
+//Usage: spectator [-s seconds] [-o frames.bin]
+//Frames can be written to a file as they are in memory, each with all its asteroid slots
+
+int main(int argc, char* argv[])
+{
+    unsigned int seconds = 10;
+    const char* output = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "-s") == 0 && has_value) seconds = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-o") == 0 && has_value) output = argv[++i];
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    FILE* record = NULL;
+    if (output != NULL && (record = fopen(output, "wb")) == NULL)
+    {
+        fprintf(stderr, "Unable to create %s\n", output);
+        return 1;
+    }
+
+    static struct spectator_frame frame;
+    const struct spectator_feed* feed = NULL;
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 end = SDL_GetPerformanceCounter() + seconds * frequency;
+    Uint64 next = 0;
+    Uint64 last_frame = 0;
+
+    //What was received
+    Uint64 received = 0, missed = 0, retries = 0, asteroids = 0;
+    int most_asteroids = 0, score = 0;
+    double latency = 0, worst_latency = 0;
+
+    while (SDL_GetPerformanceCounter() < end)
+    {
+        //Game may not be started yet, or may have been started again with a new feed
+        if (feed == NULL || (received > 0 && SDL_GetPerformanceCounter() - last_frame > frequency))
+        {
+            if (feed != NULL) spectatorClose(feed);
+            feed = spectatorOpen();
+            next = feed != NULL ? (Uint32)SDL_AtomicGet((SDL_atomic_t*)&feed->published) : 0;
+            last_frame = SDL_GetPerformanceCounter();
+            if (feed == NULL)
+            {
+                SDL_Delay(100);
+                continue;
+            }
+        }
+
+        Uint64 published = (Uint32)SDL_AtomicGet((SDL_atomic_t*)&feed->published);
+        if (next >= published)
+        {
+            SDL_Delay(1);
+            continue;
+        }
+
+        //Frames older than the ring are gone
+        if (published - next > spectator_slots_quantity)
+        {
+            missed += published - next - spectator_slots_quantity;
+            next = published - spectator_slots_quantity;
+        }
+
+        if (!spectatorRead(feed, next, &frame))
+        {
+            //Slot was being written: either this frame is being replaced and is lost, or it isn't finished yet
+            if ((Uint32)SDL_AtomicGet((SDL_atomic_t*)&feed->published) - next >= spectator_slots_quantity)
+            {
+                missed++;
+                next++;
+            }
+            else retries++;
+            continue;
+        }
+
+        Uint64 now = SDL_GetPerformanceCounter();
+        double ms = (now - frame.published) * 1000.0 / frequency;
+        latency += ms;
+        if (ms > worst_latency) worst_latency = ms;
+        asteroids += frame.asteroids_count;
+        if (frame.asteroids_count > most_asteroids) most_asteroids = frame.asteroids_count;
+        score = frame.score;
+        received++;
+        last_frame = now;
+        next++;
+
+        if (record != NULL) fwrite(&frame, sizeof(frame), 1, record);
+    }
+
+    if (feed != NULL) spectatorClose(feed);
+    if (record != NULL) fclose(record);
+
+    if (received == 0)
+    {
+        printf("No frames received in %u s, is the game running?\n", seconds);
+        return 1;
+    }
+    printf("%llu frames received, %llu missed, %llu reads retried\n", (unsigned long long)received,
+           (unsigned long long)missed, (unsigned long long)retries);
+    printf("asteroids per frame: %.1f on average, %d at most; last score %d\n", (double)asteroids / received, most_asteroids, score);
+    printf("latency from publish to read: %.3f ms on average, %.3f ms worst\n", latency / received, worst_latency);
+    return 0;
+}
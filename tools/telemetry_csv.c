@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "../telemetry.h"
+
+//Converts the binary telemetry log to CSV on standard output
+//Usage: telemetry_csv [telemetry.bin] > runs.csv
+
+int main(int argc, char* argv[])
+{
+    const char* path = argc > 1 ? argv[1] : TELEMETRY_PATH;
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Unable to open %s\n", path);
+        return 1;
+    }
+
+    printf("start_time,duration_ms,score,difficulty,shots_fired,packages_picked,peak_asteroids,frames");
+    for (int i = 0; i < TELEMETRY_HISTOGRAM_BUCKETS - 1; i++)
+    {
+        printf(",frames_%d_%dms", i * TELEMETRY_BUCKET_MS, (i + 1) * TELEMETRY_BUCKET_MS);
+    }
+    printf(",frames_over_%dms\n", (TELEMETRY_HISTOGRAM_BUCKETS - 1) * TELEMETRY_BUCKET_MS);
+
+    struct telemetry_record record;
+    long count = 0;
+    while (fread(&record, sizeof(record), 1, file) == 1)
+    {
+        //Anything else means the file is damaged or written by a different version
+        if (record.magic != TELEMETRY_MAGIC || record.version != TELEMETRY_VERSION || record.size != sizeof(record))
+        {
+            fprintf(stderr, "Unknown record at offset %ld, stopping\n", count * (long)sizeof(record));
+            break;
+        }
+
+        printf("%lld,%u,%d,%u,%u,%u,%u,%u", (long long)record.start_time, record.duration_ms, record.score,
+               record.difficulty, record.shots_fired, record.packages_picked, record.peak_asteroids, record.frames);
+        for (int i = 0; i < TELEMETRY_HISTOGRAM_BUCKETS; i++)
+        {
+            printf(",%u", record.frame_histogram[i]);
+        }
+        printf("\n");
+        count++;
+    }
+
+    fclose(file);
+    fprintf(stderr, "%ld records\n", count);
+    return 0;
+}
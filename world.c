@@ -0,0 +1,434 @@
+#include <string.h>
+#include <math.h>
+#include "world.h"
+
+//Events the timers of the world stand for
+enum world_event
+{
+    EVENT_START,
+    EVENT_SPAWN,
+    EVENT_COURSE,
+    EVENT_PACKAGE,
+    EVENT_RELOAD,
+    EVENT_SPEEDUP
+};
+
+void worldInit(struct world* w, int difficulty, unsigned int seed, unsigned int now)
+{
+    memset(w, 0, sizeof(*w));
+
+    //sets every asteroid and package as invisible
+    for (int i = 0; i < asteroids_quantity; i++)
+    {
+        w->all_asteroids[i].visible = false;
+        w->all_asteroids[i].dim.y = SCREEN_HEIGHT;
+    }
+    for (int i = 0; i < package_quantity; i++)
+    {
+        w->all_packages[i].y = SCREEN_HEIGHT;
+    }
+
+    //Player model
+    SDL_FRect player = { SCREEN_WIDTH / 2, SCREEN_HEIGHT - 100, PLAYER_WIDTH, PLAYER_HEIGHT };
+    w->player = player;
+
+    w->bullets_available = 10;
+    w->difficulty = difficulty;
+    w->spawn_base = 300;
+    w->spawn_step = 50;
+    w->currentTime = now;
+    w->menuTime = now;
+
+    //Everything else is started by the first tick, after the caller had a chance to change the world
+    timerInit(&w->timers, 0);
+    timerAdd(&w->timers, 0, EVENT_START);
+
+    w->seed = seed;
+}
+
+int worldRand(struct world* w)
+{
+    return xorshiftRand(&w->seed);
+}
+
+//Moves to the next asteroid slot
+static void nextAsteroid(struct world* w)
+{
+    w->asteroids_count++;
+    w->asteroids_count %= asteroids_quantity;
+}
+
+void createAsteoid(struct world* w)
+{
+    // Create asteroid(rectangle) with random parameters and add them to global array
+    struct asteroid* asteroid = &w->all_asteroids[w->asteroids_count];
+    int xy = worldRand(w) % 70 + 30;
+    SDL_FRect dim = { worldRand(w) % 1000, -worldRand(w) % 100 - 100, xy, xy};
+    asteroid->dim = dim;
+    asteroid->speed = (worldRand(w)%501 + 900)/1000.0;
+    asteroid->visible = true;
+    asteroid->texture = worldRand(w) % 9;
+    if(xy > 70) asteroid->HP = 2;
+    else asteroid->HP = 1;
+    asteroid->is_hit=false;
+    asteroid->angle = worldRand(w)%360 + 1;
+    asteroid->rotation = (worldRand(w)%40 + 1)/100.0;
+    nextAsteroid(w);
+}
+
+void createCourseAsteroid(struct world* w, const struct course_asteroid* a)
+{
+    struct asteroid* asteroid = &w->all_asteroids[w->asteroids_count];
+    SDL_FRect dim = { a->x, a->y, a->size, a->size};
+    asteroid->dim = dim;
+    asteroid->speed = a->speed / 1000.0;
+    asteroid->visible = true;
+    asteroid->texture = a->texture % 9;
+    if(a->size > 70) asteroid->HP = 2;
+    else asteroid->HP = 1;
+    asteroid->is_hit=false;
+    asteroid->angle = a->angle;
+    asteroid->rotation = a->rotation / 100.0;
+    nextAsteroid(w);
+}
+
+void createBullet(struct world* w)
+{
+    // Create bullet(square) and add them to global array
+
+    SDL_Rect bullet = { (w->player.x + PLAYER_WIDTH / 2 - 5), w->player.y, BULLET_WIDTH, BULLET_HEIGHT };
+    w->all_bullets[w->bullets_count] = bullet;
+    w->bullets_count++;
+    w->bullets_count %= bullets_quantity;
+    w->bullets_available--;
+}
+
+void createPackage(struct world* w)
+{
+    SDL_Rect package = {worldRand(w) % SCREEN_WIDTH, -worldRand(w) % 100 - 100, 75, 75};
+    w->all_packages[w->packages_count] = package;
+    w->packages_count++;
+    w->packages_count %= package_quantity;
+}
+
+//Next random asteroid comes interval + 1 ms after this one, as long as the interval isn't below 0
+static void scheduleSpawn(struct world* w, unsigned int time)
+{
+    int interval = w->spawn_base - w->spawn_step*w->difficulty - (int)(time/1000);
+    if (interval >= 0) timerAdd(&w->timers, time + interval + 1, EVENT_SPAWN);
+}
+
+//Creates the course asteroids whose time has come, the next lap starts when the last one is out
+static void spawnCourse(struct world* w, unsigned int time)
+{
+    const struct course* c = w->course;
+    const struct course_asteroid* a = courseAsteroid(c, w->course_next);
+    while (time >= w->course_start && time - w->course_start >= a->time)
+    {
+        createCourseAsteroid(w, a);
+        w->course_next++;
+        if (w->course_next == c->header->asteroids)
+        {
+            w->course_next = 0;
+            w->course_start += c->header->duration_ms;
+        }
+        a = courseAsteroid(c, w->course_next);
+    }
+    timerAdd(&w->timers, w->course_start + a->time, EVENT_COURSE);
+}
+
+static void worldEvent(void* data, int event, unsigned int time)
+{
+    struct world* w = data;
+    switch (event)
+    {
+    case EVENT_START:
+        if (w->course == NULL) scheduleSpawn(w, time);
+        timerAdd(&w->timers, time + PACKAGE_FIRST, EVENT_PACKAGE);
+        timerAdd(&w->timers, time + SPEEDUP_INTERVAL, EVENT_SPEEDUP);
+        break;
+    case EVENT_SPAWN:
+        //Random asteroids stop when a course takes over
+        if (w->course != NULL) break;
+        createAsteoid(w);
+        scheduleSpawn(w, time);
+        break;
+    case EVENT_COURSE:
+        spawnCourse(w, time);
+        break;
+    case EVENT_PACKAGE:
+        createPackage(w);
+        timerAdd(&w->timers, time + PACKAGE_INTERVAL, EVENT_PACKAGE);
+        break;
+    case EVENT_RELOAD:
+        w->reloading = false;
+        break;
+    case EVENT_SPEEDUP:
+        w->fall = time / 20000.0;
+        timerAdd(&w->timers, time + SPEEDUP_INTERVAL, EVENT_SPEEDUP);
+        break;
+    }
+}
+
+void worldSetCourse(struct world* w, const struct course* c)
+{
+    w->course = c;
+    w->course_next = 0;
+    w->course_start = w->clock;
+    timerAdd(&w->timers, w->course_start + courseAsteroid(c, 0)->time, EVENT_COURSE);
+}
+
+void worldMovePlayer(struct world* w, struct world_input input)
+{
+    SDL_FRect* player = &w->player;
+    float speed = PLAYER_SPEED;
+    if((input.up || input.down) && (input.right || input.left)) speed = sqrt(speed);
+    //First condition checks input && second condition keeps player in the playable area
+    if (input.up && player->y > SCREEN_HEIGHT / 2) player->y -= speed;
+    if (input.down && player->y + PLAYER_HEIGHT <= SCREEN_HEIGHT) player->y += speed;
+    if (input.left && player->x > 0) player->x -= speed;
+    if (input.right && player->x + PLAYER_WIDTH <= SCREEN_WIDTH) player->x += speed;
+    if (input.fire && !w->reloading && w->bullets_available != 0)
+    {
+        createBullet(w);
+        w->shots_fired++;
+        w->fired = true;
+        w->reloading = true;
+        timerAdd(&w->timers, w->clock + BULLET_COOLDOWN, EVENT_RELOAD);
+    }
+}
+
+SDL_Rect convert(SDL_FRect frect)
+{
+    SDL_Rect rect;
+
+    rect.h = (int)frect.h;
+    rect.w = (int)frect.w;
+    rect.x = (int)frect.x;
+    rect.y = (int)frect.y;
+    return rect;
+}
+
+//Remembers a hit for the renderer, extra hits in one step are skipped
+static void addHit(struct world* w, float x, float y, float size, bool destroyed)
+{
+    if (w->hits_count == hits_quantity) return;
+    struct world_hit hit = {x, y, size, destroyed};
+    w->hits[w->hits_count++] = hit;
+}
+
+bool collisionCheckAsteroid(struct world* w, struct asteroid* asteroids, int count)
+{
+    SDL_Rect player_rect = convert(w->player);
+    //Use SDL_HasIntersection to see if asteroid collides with player
+    for (int i = 0; i < count; i++)
+    {
+        struct asteroid* asteroid = &asteroids[i];
+        SDL_Rect rect = convert(asteroid->dim);
+
+        if (SDL_HasIntersection(&player_rect, &rect))
+        {
+            return false;
+        }
+        if (collisionCheckBullet(w, asteroid) == false  && asteroid->HP == 0)
+        {
+            //If asteroid collides with bullet, change asteroid size to 0 and change position to player's y to get a point
+            addHit(w, asteroid->dim.x + asteroid->dim.w / 2, asteroid->dim.y + asteroid->dim.h / 2, asteroid->dim.w, true);
+            asteroid->dim.h = 0;
+            asteroid->dim.w = 0;
+            asteroid->dim.x = 0;
+            asteroid->dim.y = w->player.y-1;
+        }
+    }
+
+    return true;
+}
+
+bool collisionCheckBullet(struct world* w, struct asteroid* asteroid)
+{
+    SDL_Rect rect = convert(asteroid->dim);
+    //Use SDL_HasIntersection to see if bullet collides with asteroid and delete them if so
+    for (int i = 0; i < bullets_quantity; i++)
+    {
+        SDL_Rect* bullet = &w->all_bullets[i];
+        if (SDL_HasIntersection(&rect, bullet))
+        {
+            addHit(w, bullet->x + bullet->w / 2, bullet->y, bullet->w, false);
+            asteroid->HP--;
+            asteroid->is_hit = true;
+            bullet->h = 0;
+            bullet->w = 0;
+            bullet->x = 0;
+            bullet->y = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool collisionCheckPackage(struct world* w)
+{
+    SDL_Rect player_rect = convert(w->player);
+    for(int i = 0; i < w->packages_count; i++)
+    {
+        if(SDL_HasIntersection(&player_rect, &w->all_packages[i]))
+        {
+            w->all_packages[i].w = 0;
+            w->all_packages[i].h = 0;
+            w->all_packages[i].x = 0;
+            w->all_packages[i].y = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+void asteroidMovement(struct world* w, struct asteroid* asteroids, int count)
+{
+    for(int i = 0; i < count; i++)
+    {
+        asteroids[i].dim.y += asteroids[i].speed + w->fall;
+        asteroids[i].angle += asteroids[i].rotation;
+    }
+}
+
+//Packages and bullets, asteroids are moved separately
+static void bulletAndPackageMovement(struct world* w)
+{
+    for(int i = 0; i < package_quantity; i++)
+    {
+        w->all_packages[i].y += PACKAGE_SPEED;
+    }
+    for(int i = 0; i < bullets_quantity; i++)
+    {
+        w->all_bullets[i].y -= BULLET_SPEED;
+    }
+}
+
+void asteroidBulletAndPackageMovement(struct world* w)
+{
+    asteroidMovement(w, w->all_asteroids, asteroids_quantity);
+    bulletAndPackageMovement(w);
+}
+
+void getScore(struct world* w, struct asteroid* asteroids, int count)
+{
+    //Looks at all asteroids and if player is higher than asteroid then it adds one to the score
+    for (int i = 0; i < count; i++)
+    {
+        if (w->player.y < asteroids[i].dim.y && asteroids[i].visible == true)
+        {
+            w->currentScore++;
+            asteroids[i].visible = false;
+        }
+    }
+}
+
+//Asteroid is on the screen and not destroyed
+static bool asteroidShown(struct asteroid* asteroid)
+{
+    return asteroid->dim.w > 0 && asteroid->dim.y < SCREEN_HEIGHT && asteroid->dim.y + asteroid->dim.h > 0;
+}
+
+static void addDraw(struct asteroid_draw* draw, struct asteroid* asteroid)
+{
+    draw->dim = asteroid->dim;
+    draw->angle = asteroid->angle;
+    draw->texture = asteroid->texture;
+    draw->is_hit = asteroid->is_hit;
+}
+
+int asteroidsUpdate(struct world* w, struct asteroid* asteroids, int count, struct asteroid_draw* draw)
+{
+    SDL_Rect player_rect = convert(w->player);
+    int drawn = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        struct asteroid* asteroid = &asteroids[i];
+
+        //Retired: already counted and either destroyed or below the reach of the player
+        if (asteroid->dim.w == 0 && asteroid->visible == false) continue;
+
+        asteroid->dim.y += asteroid->speed + w->fall;
+        asteroid->angle += asteroid->rotation;
+
+        SDL_Rect rect = convert(asteroid->dim);
+        if (SDL_HasIntersection(&player_rect, &rect)) return -1;
+
+        if (collisionCheckBullet(w, asteroid) == false && asteroid->HP == 0)
+        {
+            //Destroyed asteroid is moved to player's y, so it still gives a point
+            addHit(w, asteroid->dim.x + asteroid->dim.w / 2, asteroid->dim.y + asteroid->dim.h / 2, asteroid->dim.w, true);
+            asteroid->dim.h = 0;
+            asteroid->dim.w = 0;
+            asteroid->dim.x = 0;
+            asteroid->dim.y = w->player.y-1;
+        }
+
+        if (w->player.y < asteroid->dim.y && asteroid->visible == true)
+        {
+            w->currentScore++;
+            asteroid->visible = false;
+        }
+
+        if (asteroid->visible == false && asteroid->dim.y > SCREEN_HEIGHT + PLAYER_SPEED)
+        {
+            asteroid->dim.w = 0;
+            asteroid->dim.h = 0;
+        }
+
+        if (draw != NULL && asteroidShown(asteroid)) addDraw(&draw[drawn++], asteroid);
+    }
+    return drawn;
+}
+
+int asteroidsDrawList(struct asteroid* asteroids, int count, struct asteroid_draw* draw)
+{
+    int drawn = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (asteroidShown(&asteroids[i])) addDraw(&draw[drawn++], &asteroids[i]);
+    }
+    return drawn;
+}
+
+void worldDrawList(struct world* w, struct world_draw* draw)
+{
+    draw->asteroids_count = asteroidsDrawList(w->all_asteroids, asteroids_quantity, draw->asteroids);
+}
+
+bool worldStep(struct world* w, struct world_input input, struct world_draw* draw)
+{
+    w->fired = false;
+    w->hits_count = 0;
+
+    worldMovePlayer(w, input);
+    bulletAndPackageMovement(w);
+    int drawn = asteroidsUpdate(w, w->all_asteroids, asteroids_quantity, draw != NULL ? draw->asteroids : NULL);
+    if (drawn < 0) return false;
+    if (draw != NULL) draw->asteroids_count = drawn;
+
+    if (!collisionCheckPackage(w))
+    {
+        w->packages_picked++;
+        w->bullets_available += 10;
+    }
+    return true;
+}
+
+void worldTick(struct world* w, unsigned int now)
+{
+    w->clock += now - w->currentTime;
+    w->currentTime = now;
+    timerAdvance(&w->timers, w->clock, worldEvent, w);
+}
+
+void worldResume(struct world* w, unsigned int now)
+{
+    unsigned int shift = now - w->currentTime;
+
+    //clock and the timers don't move, the rewound ms were never played
+    w->currentTime += shift;
+    w->menuTime += shift;
+}
@@ -0,0 +1,216 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+#include "course.h"
+#include "timer.h"
+
+static const int SCREEN_WIDTH = 800;
+static const int SCREEN_HEIGHT = 800;
+static const int PLAYER_WIDTH = SCREEN_WIDTH / 12;
+static const int PLAYER_HEIGHT = SCREEN_HEIGHT / 12;
+static const int PLAYER_SPEED = 2;
+static const int BULLET_WIDTH = 10;
+static const int BULLET_HEIGHT = 10;
+static const int BULLET_SPEED = 4;
+static const int BULLET_COOLDOWN = 1500;
+static const int PACKAGE_SPEED = 2;
+
+//Ms of play until the first package, and between packages after it
+static const int PACKAGE_FIRST = 3000;
+static const int PACKAGE_INTERVAL = 50000;
+
+//Ms between speed ups of the asteroids
+static const int SPEEDUP_INTERVAL = 100;
+
+//Quantity of asteroids
+#define asteroids_quantity 200
+
+//Quantity of bullets
+#define bullets_quantity 20
+
+//Quantity of packages
+#define package_quantity 5
+
+//Quantity of hits remembered during one step
+#define hits_quantity 16
+
+//Asteroid flying down the screen
+struct asteroid
+{
+    SDL_FRect dim;
+    int texture;
+    float speed;
+    bool visible;
+    int HP;
+    bool is_hit;
+    double rotation;
+    double angle;
+};
+
+//What the renderer needs to draw one asteroid
+struct asteroid_draw
+{
+    SDL_FRect dim;
+    float angle;
+    int texture;
+    bool is_hit;
+};
+
+//Asteroids that can be seen after a step, written while the step goes through them
+struct world_draw
+{
+    struct asteroid_draw asteroids[asteroids_quantity];
+    int asteroids_count;
+};
+
+//Bullet hitting an asteroid, used by the renderer for effects
+struct world_hit
+{
+    float x;
+    float y;
+    float size;
+    bool destroyed;
+};
+
+//Keys held during one step
+struct world_input
+{
+    bool up;
+    bool down;
+    bool left;
+    bool right;
+    bool fire;
+};
+
+//Everything one game needs, several worlds can run side by side
+struct world
+{
+    struct asteroid all_asteroids[asteroids_quantity];
+    SDL_Rect all_bullets[bullets_quantity];
+    SDL_Rect all_packages[package_quantity];
+    SDL_FRect player;
+
+    //Counters of asteroids, bullets and packages
+    int asteroids_count;
+    int bullets_count;
+    int bullets_available;
+    int packages_count;
+
+    //Locks shot speed until the cooldown timer expires
+    bool reloading;
+
+    //Time in ms, menuTime is when the game started. clock counts only the ms that were played,
+    //it runs the timers and doesn't move during pauses and rewinds
+    unsigned int currentTime, menuTime;
+    unsigned int clock;
+    struct timer_wheel timers;
+
+    //How much faster than their own speed asteroids fall, raised by a timer as the game goes on
+    float fall;
+
+    int currentScore;
+    int difficulty;
+
+    //Asteroid spawn interval is spawn_base - spawn_step * difficulty ms, shortened by 1 ms every second.
+    //Asteroids stop coming when it gets below 0
+    int spawn_base;
+    int spawn_step;
+
+    //State of the world's own random generator
+    unsigned int seed;
+
+    //Course the asteroids come from instead of the generator, NULL when there is none.
+    //course_next is the next asteroid of it and course_start is the clock when the current lap started
+    const struct course* course;
+    uint64_t course_next;
+    unsigned int course_start;
+
+    //Statistics of the whole game
+    int shots_fired;
+    int packages_picked;
+
+    //What happened during the last step
+    bool fired;
+    int hits_count;
+    struct world_hit hits[hits_quantity];
+};
+
+//Next xorshift number from 0 to 2^31 - 1. State 0 would only ever give 0, so it is taken as 1
+static inline int xorshiftRand(unsigned int* state)
+{
+    unsigned int x = *state != 0 ? *state : 1;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x >> 1;
+}
+
+//Resets the world for a new game started at time now
+void worldInit(struct world* w, int difficulty, unsigned int seed, unsigned int now);
+
+//Returns random number from 0 to 2^31 - 1, same for the same seed
+int worldRand(struct world* w);
+
+//Creates an asteroid
+void createAsteoid(struct world* w);
+
+//Creates an asteroid from a course
+void createCourseAsteroid(struct world* w, const struct course_asteroid* a);
+
+//Creates a bullet
+void createBullet(struct world* w);
+
+//Creates a package with bullets
+void createPackage(struct world* w);
+
+//Makes asteroids come from the course starting now, the course has to stay open while the world uses it
+void worldSetCourse(struct world* w, const struct course* c);
+
+//Moves player and shoots according to held keys
+void worldMovePlayer(struct world* w, struct world_input input);
+
+//converts SDL_Rect to SDL_FRect
+SDL_Rect convert(SDL_FRect frect);
+
+//Checks asteroids for collision with the player and bullets
+bool collisionCheckAsteroid(struct world* w, struct asteroid* asteroids, int count);
+
+//Checks all bullets for collision with the asteroid
+bool collisionCheckBullet(struct world* w, struct asteroid* asteroid);
+
+//Checks all packages for collision
+bool collisionCheckPackage(struct world* w);
+
+//Lowers and rotates asteroids
+void asteroidMovement(struct world* w, struct asteroid* asteroids, int count);
+
+//Lowers asteroids, packages and makes bullets go up
+void asteroidBulletAndPackageMovement(struct world* w);
+
+//Counts score (+1 per dodged asteroid)
+void getScore(struct world* w, struct asteroid* asteroids, int count);
+
+//Does everything a step does to asteroids in one pass over them: movement, rotation, collisions, score and
+//retiring the ones that can't matter anymore. Asteroids that can be seen are written to draw when it isn't NULL.
+//Returns how many were written, or -1 when one of them hit the player
+int asteroidsUpdate(struct world* w, struct asteroid* asteroids, int count, struct asteroid_draw* draw);
+
+//Writes asteroids that can be seen to draw without changing them, returns how many were written
+int asteroidsDrawList(struct asteroid* asteroids, int count, struct asteroid_draw* draw);
+
+//Fills draw with the world as it is now
+void worldDrawList(struct world* w, struct world_draw* draw);
+
+//Plays one frame of the game, returns false when the player got hit. draw can be NULL when nothing is rendered
+bool worldStep(struct world* w, struct world_input input, struct world_draw* draw);
+
+//Moves the clock of the world to now and handles the timers that expired: spawns, packages, cooldown and speed ups
+void worldTick(struct world* w, unsigned int now);
+
+//Shifts all times of the world so a game restored from the past goes on from now
+void worldResume(struct world* w, unsigned int now);
+
+#endif
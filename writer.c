@@ -0,0 +1,113 @@
+#include <string.h>
+#include <unistd.h>
+#include "writer.h"
+
+static void* slotAt(struct writer* w, Uint32 position)
+{
+    return w->items + (size_t)(position & (w->quantity - 1)) * w->item_size;
+}
+
+static int writerThread(void* data)
+{
+    struct writer* w = data;
+
+    while (true)
+    {
+        SDL_SemWaitTimeout(w->ready, 1000);
+        bool running = SDL_AtomicGet(&w->running);
+
+        //Every slot goes back as soon as its item is taken
+        Uint32 head = SDL_AtomicGet(&w->head);
+        Uint32 tail = SDL_AtomicGet(&w->tail);
+        bool took = tail != head;
+        while (tail != head)
+        {
+            w->take(w->data, slotAt(w, tail));
+            tail++;
+            SDL_AtomicSet(&w->tail, tail);
+        }
+        if (took && w->flush != NULL) w->flush(w->data);
+
+        if (!running && tail == (Uint32)SDL_AtomicGet(&w->head)) break;
+    }
+    return 0;
+}
+
+bool writerStart(struct writer* w, const char* name, void* items, int item_size, int quantity, writer_take take,
+                 writer_flush flush, void* data)
+{
+    memset(w, 0, sizeof(*w));
+    w->items = items;
+    w->item_size = item_size;
+    w->quantity = quantity;
+    w->take = take;
+    w->flush = flush;
+    w->data = data;
+    SDL_AtomicSet(&w->running, 1);
+
+    w->ready = SDL_CreateSemaphore(0);
+    if (w->ready != NULL) w->thread = SDL_CreateThread(writerThread, name, w);
+    if (w->thread == NULL)
+    {
+        SDL_AtomicSet(&w->running, 0);
+        writerStop(w);
+        return false;
+    }
+    return true;
+}
+
+void* writerSlot(struct writer* w)
+{
+    if (w->thread == NULL) return NULL;
+
+    Uint32 head = SDL_AtomicGet(&w->head);
+    Uint32 tail = SDL_AtomicGet(&w->tail);
+    if (head - tail >= (Uint32)w->quantity)
+    {
+        SDL_AtomicAdd(&w->dropped, 1);
+        return NULL;
+    }
+    return slotAt(w, head);
+}
+
+void writerPublish(struct writer* w)
+{
+    //Slot has to be complete before the thread can see the new head
+    SDL_AtomicAdd(&w->head, 1);
+    SDL_SemPost(w->ready);
+}
+
+bool writerSubmit(struct writer* w, const void* item)
+{
+    void* slot = writerSlot(w);
+    if (slot == NULL) return false;
+    memcpy(slot, item, w->item_size);
+    writerPublish(w);
+    return true;
+}
+
+void writerStop(struct writer* w)
+{
+    if (w->thread != NULL)
+    {
+        SDL_AtomicSet(&w->running, 0);
+        SDL_SemPost(w->ready);
+        SDL_WaitThread(w->thread, NULL);
+        w->thread = NULL;
+    }
+    if (w->ready != NULL) SDL_DestroySemaphore(w->ready);
+    w->ready = NULL;
+}
+
+bool writeAll(int file, const void* data, size_t length)
+{
+    const char* bytes = data;
+    while (length > 0)
+    {
+        ssize_t written = write(file, bytes, length);
+        if (written < 0) return false;
+        bytes += written;
+        length -= written;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <SDL2/SDL.h>
+
+//Handles one item on the writer thread; the slot is given back to the producer when it returns
+typedef void (*writer_take)(void* data, void* item);
+
+//Called on the writer thread after every pass that took items, e.g. to write them out at once
+typedef void (*writer_flush)(void* data);
+
+//Ring of fixed size items passed from one producing thread to a background thread that does the slow work.
+//The producer only moves head, the writer thread only moves tail, so neither ever waits for the other
+struct writer
+{
+    Uint8* items;
+    int item_size;
+    int quantity;
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+    SDL_atomic_t dropped;
+
+    //Set to 0 when the thread has to take what is left and finish
+    SDL_atomic_t running;
+
+    SDL_sem* ready;
+    SDL_Thread* thread;
+    writer_take take;
+    writer_flush flush;
+    void* data;
+};
+
+//Starts the thread over quantity slots of item_size bytes in items, quantity has to be a power of two.
+//flush can be NULL. Returns false when the thread can't be started
+bool writerStart(struct writer* w, const char* name, void* items, int item_size, int quantity, writer_take take,
+                 writer_flush flush, void* data);
+
+//Slot the producer fills next, NULL when all are taken (the item is then counted as dropped)
+void* writerSlot(struct writer* w);
+
+//Hands the filled slot to the thread
+void writerPublish(struct writer* w);
+
+//Copies item into the next slot and hands it over, never blocks; returns false when it was dropped
+bool writerSubmit(struct writer* w, const void* item);
+
+//Lets the thread take everything still queued and waits for it to finish
+void writerStop(struct writer* w);
+
+//Writes the whole buffer to the file, write can take only part of it
+bool writeAll(int file, const void* data, size_t length);
+
+#endif